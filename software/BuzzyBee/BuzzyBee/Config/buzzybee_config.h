@@ -0,0 +1,96 @@
+/* BuzzyBee application configuration */
+#ifndef BUZZYBEE_CONFIG_H
+#define BUZZYBEE_CONFIG_H
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h> I2C slave
+
+// <o> 7-bit slave address on the SAO header <0x08-0x77>
+// <id> i2c_slave_address
+#ifndef I2C_SLAVE_ADDRESS
+#define I2C_SLAVE_ADDRESS 0x42
+#endif
+
+// <q> Fast-mode Plus
+// <i> Up to 1MHz SCL. Needs bus pull-ups strong enough for Fast-mode Plus rise times.
+// <id> i2c_fast_mode_plus
+#ifndef I2C_FAST_MODE_PLUS
+#define I2C_FAST_MODE_PLUS 1
+#endif
+
+// <q> Accept general call sync broadcasts
+// <i> Lets one broadcast align the animation clocks of every BuzzyBee on the bus
+// <id> i2c_general_call_sync
+#ifndef I2C_GENERAL_CALL_SYNC
+#define I2C_GENERAL_CALL_SYNC 1
+#endif
+
+// </h>
+
+// <e> Publish touch events as I2C master
+// <i> Multi-master: on a touch edge, write an event record to a peer instead of waiting to be polled
+// <id> i2c_publish_enable
+#ifndef I2C_PUBLISH_ENABLE
+#define I2C_PUBLISH_ENABLE 0
+#endif
+
+// <o> Peer address <0x08-0x77>
+// <id> i2c_publish_address
+#ifndef I2C_PUBLISH_ADDRESS
+#define I2C_PUBLISH_ADDRESS 0x43
+#endif
+
+// <o> SCL frequency in Hz <1000-1000000>
+// <id> i2c_publish_frequency
+#ifndef I2C_PUBLISH_FREQUENCY
+#define I2C_PUBLISH_FREQUENCY 100000
+#endif
+
+// <o> Attempts after losing arbitration, before the record is dropped <1-8>
+// <id> i2c_publish_retries
+#ifndef I2C_PUBLISH_RETRIES
+#define I2C_PUBLISH_RETRIES 5
+#endif
+
+// </e>
+
+// <q> Light pattern interpreter
+// <i> Programs uploaded over I2C and run as MODE_PROGRAM, see vm.h. Takes about 1.2 kB of flash, 1 kB of it the interpreter, and 17 bytes of RAM. Off, the program registers read back 0xFF and ignore writes.
+// <id> vm_enable
+#ifndef VM_ENABLE
+#define VM_ENABLE 1
+#endif
+
+// <h> Animation
+
+// <o> Mode crossfade time in ms <0-2000>
+// <i> How long the outgoing and incoming modes are blended on a mode change, 0 cuts straight over
+// <id> transition_ms
+#ifndef TRANSITION_MS
+#define TRANSITION_MS 400
+#endif
+
+// </h>
+
+// <h> Haptics
+
+// <o> Overdrive on start in ms <0-255>
+// <i> Full duty for up to this long on a rise, in proportion to the rise, to spin the motor up sooner. A rise to full is at full duty anyway.
+// <id> haptic_kick_ms
+#ifndef HAPTIC_KICK_MS
+#define HAPTIC_KICK_MS 50
+#endif
+
+// <o> Brake on stop in ms <0-255>
+// <i> Off for up to this long on a fall, in proportion to the fall, so a lower level takes over sooner. A stop is off anyway.
+// <id> haptic_brake_ms
+#ifndef HAPTIC_BRAKE_MS
+#define HAPTIC_BRAKE_MS 50
+#endif
+
+// </h>
+
+// <<< end of configuration section >>>
+
+#endif // BUZZYBEE_CONFIG_H
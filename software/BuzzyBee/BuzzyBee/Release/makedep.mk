@@ -4,16 +4,42 @@
 
 atmel_start.c
 
+compositor.c
+
 driver_isr.c
 
+entropy.c
+
 examples\src\i2c_slave_example.c
 
 examples\src\touch_example.c
 
+framebuffer.c
+
+haptic.c
+
+i2c_publish.c
+
+i2c_registers.c
+
+keyframe.c
+
+lut.c
+
+mailbox.c
+
 main.c
 
+prng.c
+
+qtouch\datastreamer\datastreamer_UART_tiny.c
+
 qtouch\touch.c
 
+render.c
+
+settings.c
+
 src\bod.c
 
 src\clkctrl.c
@@ -22,6 +48,8 @@ src\cpuint.c
 
 src\driver_init.c
 
+src\i2c_slave.c
+
 src\protected_io.S
 
 src\rtc.c
@@ -32,3 +60,6 @@ src\tca.c
 
 src\tcb.c
 
+touch_events.c
+
+vm.c
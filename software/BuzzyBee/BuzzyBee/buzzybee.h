@@ -0,0 +1,75 @@
+/* BuzzyBee application state shared between main, the ISRs and the I2C register map */
+#ifndef BUZZYBEE_H
+#define BUZZYBEE_H
+
+#include <avr/io.h>
+#include <buzzybee_config.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	MODE_TWINKLE,
+	MODE_BOUNCE,
+	MODE_RANDOM,
+	MODE_STREAM, // LEDs driven by frames from the I2C host
+	MODE_PROGRAM // Program uploaded to EEPROM, see vm.h
+} RUNMODE;
+
+// Highest mode that can be selected
+#if VM_ENABLE == 1
+#define MODE_LAST MODE_PROGRAM
+#else
+#define MODE_LAST MODE_STREAM
+#endif
+
+// Idle LED level
+#define LED_GLOW 71
+
+// LED levels, index 0 is LED_RIGHT and 1 is LED_LEFT. Levels are perceptual,
+// see lut.h
+extern volatile uint8_t LED_PWM[2];
+// Brightness ceiling applied on top of LED_PWM
+extern volatile uint8_t LED_CEILING;
+// Lowest ceiling the slider, I2C or saved settings can set, so the LEDs never go fully dark
+#define CEILING_MIN 76
+// Milliseconds since TIMER_1 started, wraps
+extern volatile uint16_t timeTicks;
+
+// Current mode, may also be changed over I2C
+extern volatile RUNMODE run_mode;
+// Number of touches seen on each key, wraps
+extern volatile uint8_t touch_count[2];
+// Set by a general call sync, the animation restarts in step with the other boards
+extern volatile bool animation_synced;
+extern volatile uint16_t animation_sync_time;
+
+// PWM and tick ISR state, see driver_isr.c
+extern uint8_t pwm_counter;
+extern uint8_t render_periods;
+extern volatile bool tick_synced;
+extern volatile uint16_t tick_sync_time;
+
+/*============================================================================
+static inline void pwm_sync(uint16_t time)
+------------------------------------------------------------------------------
+Purpose: Restart the PWM period, the render schedule and the millisecond
+         tick, so boards synced by one general call broadcast run in phase
+Input  : time: millisecond clock at the sync
+Output : none
+Notes  : Called from the I2C ISR. The TCB0 ISR may be part way through its
+         increment, so it takes the new time itself on the next tick
+         instead of having timeTicks written under it. A tick already
+         pending is dropped, as it belongs to the period before the sync.
+============================================================================*/
+static inline __attribute__((always_inline)) void pwm_sync(uint16_t time)
+{
+	TCA0.SINGLE.CNT = 0;
+	TCB0.CNT        = 0;
+	TCB0.INTFLAGS   = TCB_CAPT_bm;
+	pwm_counter     = 0;
+	render_periods  = 0;
+	tick_sync_time  = time + 1;
+	tick_synced     = true;
+}
+
+#endif // BUZZYBEE_H
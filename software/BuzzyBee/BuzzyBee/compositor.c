@@ -0,0 +1,256 @@
+/* BuzzyBee compositor, see compositor.h */
+
+#include <atmel_start.h>
+#include <buzzybee_config.h>
+
+#include "buzzybee.h"
+#include "compositor.h"
+#include "keyframe.h"
+#include "render.h"
+#include "vm.h"
+
+// Opacity an overlay loses per render as it fades out, renders are ~10 ms
+#if TRANSITION_MS > 10
+#define LAYER_FADE_STEP ((255 * 10 + TRANSITION_MS / 2) / TRANSITION_MS)
+#else
+#define LAYER_FADE_STEP 255
+#endif
+
+enum {
+	SOURCE_NONE, // LEDs left alone
+	SOURCE_HOLD, // Fixed levels in comp_hold
+	SOURCE_KEYFRAME0,
+	SOURCE_KEYFRAME1,
+#if VM_ENABLE == 1
+	SOURCE_VM
+#endif
+};
+
+typedef struct {
+	uint8_t mask;    // Channels covered, bit 0 LED_RIGHT, bit 1 LED_LEFT
+	uint8_t level;
+	uint8_t op;      // BLEND_x
+	uint8_t opacity; // 0 is off
+	bool    fading;  // Released
+} comp_layer_t;
+
+// Two players, so an effect can fade into another
+static keyframe_player_t comp_player[2];
+static comp_layer_t      comp_layer[LAYER_COUNT];
+static uint8_t           comp_in;
+static uint8_t           comp_out;
+static uint8_t           comp_hold[2];
+// The effects' blended levels, under the overlays
+static uint8_t           comp_base[2];
+static uint16_t          comp_start;
+
+static uint16_t comp_now(void)
+{
+	uint16_t now;
+
+	cpu_irq_disable();
+	now = timeTicks;
+	cpu_irq_enable();
+	return now;
+}
+
+/*============================================================================
+static uint8_t comp_mix(uint8_t a, uint8_t b, uint8_t alpha)
+------------------------------------------------------------------------------
+Purpose: Blend two levels
+Input  : a, b: levels
+         alpha: 0 for a, 255 for b
+Output : blended level
+Notes  :
+============================================================================*/
+static uint8_t comp_mix(uint8_t a, uint8_t b, uint8_t alpha)
+{
+	if (b >= a) {
+		return a + ((uint16_t)(b - a) * (alpha + 1) >> 8);
+	}
+	return a - ((uint16_t)(a - b) * (alpha + 1) >> 8);
+}
+
+/*============================================================================
+static const uint8_t *comp_render(uint8_t source)
+------------------------------------------------------------------------------
+Purpose: Bring a source up to date
+Input  : source: SOURCE_x, not SOURCE_NONE
+Output : the source's LED levels
+Notes  :
+============================================================================*/
+static const uint8_t *comp_render(uint8_t source)
+{
+	switch (source) {
+	case SOURCE_KEYFRAME0:
+	case SOURCE_KEYFRAME1:
+		keyframe_update(&comp_player[source - SOURCE_KEYFRAME0]);
+		return comp_player[source - SOURCE_KEYFRAME0].out;
+#if VM_ENABLE == 1
+	case SOURCE_VM:
+		vm_update();
+		return vm_led;
+#endif
+	default:
+		return comp_hold;
+	}
+}
+
+/*============================================================================
+void compositor_start(uint8_t mode, bool fade)
+------------------------------------------------------------------------------
+Purpose: Switch the bottom layer to a mode's effect
+Input  : mode: run mode
+         fade: false to cut straight over, as a sync restart must
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void compositor_start(uint8_t mode, bool fade)
+{
+	uint8_t incoming;
+
+	if (!fade || TRANSITION_MS == 0) {
+		comp_out = SOURCE_NONE;
+	} else if (comp_in == SOURCE_NONE) {
+		// Fade out of the last stream frame
+		comp_hold[0] = LED_PWM[0];
+		comp_hold[1] = LED_PWM[1];
+		comp_out     = SOURCE_HOLD;
+#if VM_ENABLE == 1
+	} else if (comp_out != SOURCE_NONE || comp_in == SOURCE_VM) {
+#else
+	} else if (comp_out != SOURCE_NONE) {
+#endif
+		// Mid transition, or the VM: fade out of what shows now
+		comp_hold[0] = comp_base[0];
+		comp_hold[1] = comp_base[1];
+		comp_out     = SOURCE_HOLD;
+	} else {
+		comp_out = comp_in;
+	}
+	comp_start = comp_now();
+
+	if (mode == MODE_STREAM) {
+		incoming   = SOURCE_NONE;
+		comp_out   = SOURCE_NONE;
+		LED_PWM[0] = LED_GLOW;
+		LED_PWM[1] = LED_GLOW;
+#if VM_ENABLE == 1
+	} else if (mode == MODE_PROGRAM) {
+		incoming = SOURCE_VM;
+		vm_start();
+#endif
+	} else {
+		// Not the player the outgoing effect is on
+		incoming = (comp_out == SOURCE_KEYFRAME0) ? SOURCE_KEYFRAME1 : SOURCE_KEYFRAME0;
+		keyframe_start(&comp_player[incoming - SOURCE_KEYFRAME0], mode);
+	}
+	comp_in = incoming;
+}
+
+/*============================================================================
+void compositor_layer(uint8_t layer, uint8_t mask, uint8_t level, uint8_t op,
+                      uint8_t opacity)
+------------------------------------------------------------------------------
+Purpose: Show an overlay
+Input  : layer: LAYER_x
+         mask: channels covered, bit 0 LED_RIGHT, bit 1 LED_LEFT
+         level: LED level
+         op: BLEND_x
+         opacity: 255 is opaque
+Output : none
+Notes  : Called from the main loop, shows from the next render on
+============================================================================*/
+void compositor_layer(uint8_t layer, uint8_t mask, uint8_t level, uint8_t op, uint8_t opacity)
+{
+	comp_layer_t *l = &comp_layer[layer];
+
+	l->mask    = mask;
+	l->level   = level;
+	l->op      = op;
+	l->opacity = opacity;
+	l->fading  = false;
+}
+
+/*============================================================================
+void compositor_release(uint8_t layer)
+------------------------------------------------------------------------------
+Purpose: Fade an overlay out
+Input  : layer: LAYER_x
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void compositor_release(uint8_t layer)
+{
+	comp_layer[layer].fading = true;
+}
+
+/*============================================================================
+void compositor_render(void)
+------------------------------------------------------------------------------
+Purpose: Render the effects and blend them with the overlays onto the LEDs
+Input  : none
+Output : none
+Notes  : Called in a render
+============================================================================*/
+void compositor_render(void)
+{
+	const uint8_t *in;
+
+	render_blending = false;
+	if (comp_in == SOURCE_NONE) {
+		return;
+	}
+
+	// Bottom layer, the effect, or two of them mid transition
+	in = comp_render(comp_in);
+	comp_base[0] = in[0];
+	comp_base[1] = in[1];
+#if TRANSITION_MS > 0
+	if (comp_out != SOURCE_NONE) {
+		uint16_t elapsed = comp_now() - comp_start;
+		if (elapsed < TRANSITION_MS) {
+			const uint8_t *out = comp_render(comp_out);
+			render_blending    = true;
+			// elapsed * 65536 / TRANSITION_MS without a 32 bit division
+			uint8_t alpha = (uint16_t)(elapsed * (uint16_t)(65536UL / TRANSITION_MS)) >> 8;
+			comp_base[0] = comp_mix(out[0], in[0], alpha);
+			comp_base[1] = comp_mix(out[1], in[1], alpha);
+		} else {
+			comp_out = SOURCE_NONE;
+		}
+	}
+#endif
+
+	// Overlays, bottom up
+	for (uint8_t channel = 0; channel < 2; channel++) {
+		uint8_t level = comp_base[channel];
+		for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+			comp_layer_t *l = &comp_layer[layer];
+			uint8_t       top;
+			if (l->opacity == 0 || !(l->mask & (1 << channel))) {
+				continue;
+			}
+			switch (l->op) {
+			case BLEND_MAX:
+				top = (l->level > level) ? l->level : level;
+				break;
+			case BLEND_ADD:
+				top = (level > 255 - l->level) ? 255 : level + l->level;
+				break;
+			default:
+				top = l->level;
+				break;
+			}
+			level = comp_mix(level, top, l->opacity);
+		}
+		LED_PWM[channel] = level;
+	}
+
+	for (uint8_t layer = 0; layer < LAYER_COUNT; layer++) {
+		comp_layer_t *l = &comp_layer[layer];
+		if (l->fading) {
+			l->opacity = (l->opacity > LAYER_FADE_STEP) ? l->opacity - LAYER_FADE_STEP : 0;
+		}
+	}
+}
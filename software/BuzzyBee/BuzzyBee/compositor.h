@@ -0,0 +1,48 @@
+/* BuzzyBee compositor
+ *
+ * Puts the layers on the LEDs during each render. The bottom layer is the
+ * running mode's effect. Every effect renders into its own levels, a keyframe
+ * player's or the VM's, and the compositor blends them up through the
+ * overlays into LED_PWM, per channel.
+ *
+ * On a mode change the outgoing effect keeps rendering next to the incoming
+ * one for TRANSITION_MS, and the two are blended with an 8 bit alpha that
+ * goes from the outgoing to the incoming levels. Effects that cannot keep
+ * rendering fade out from a snapshot instead: the host's stream frames, the
+ * VM (which would drive the motor if it kept running) and a transition cut
+ * short by the next one. The stream itself is shown by the PWM ISR, so in
+ * MODE_STREAM the compositor leaves the LEDs to the host.
+ *
+ * Overlays cover some channels with a level, blended onto what is below
+ * with their op at their opacity. A released overlay fades out over
+ * TRANSITION_MS, so whatever it covered shows through again by itself.
+ */
+#ifndef COMPOSITOR_H
+#define COMPOSITOR_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// Overlays, bottom up
+enum {
+	LAYER_TOUCH, // Touch feedback
+	LAYER_ALERT, // Alerts, above everything
+	LAYER_COUNT
+};
+
+// Channel mask of an overlay covering both LEDs
+#define LAYER_LEDS 0x03
+
+// Overlay blend ops
+enum {
+	BLEND_REPLACE, // The overlay's level
+	BLEND_MAX,     // The brighter of the two
+	BLEND_ADD      // Both added, saturating
+};
+
+void compositor_start(uint8_t mode, bool fade);
+void compositor_layer(uint8_t layer, uint8_t mask, uint8_t level, uint8_t op, uint8_t opacity);
+void compositor_release(uint8_t layer);
+void compositor_render(void);
+
+#endif // COMPOSITOR_H
@@ -36,10 +36,23 @@
 #include <driver_init.h>
 #include <compiler.h>
 #include "touch.h"
+#include "framebuffer.h"
+#include "haptic.h"
+#include "lut.h"
+#include "render.h"
 
 volatile uint8_t LED_PWM[2] = { 0 };
+volatile uint8_t LED_CEILING = 255;
 volatile uint16_t timeTicks = 0;
 
+// Position in the software PWM period
+uint8_t pwm_counter = 0;
+// PWM periods since the last render was due
+uint8_t render_periods = 0;
+// Millisecond clock for the TCB0 ISR to take on its next tick, see pwm_sync()
+volatile bool tick_synced = false;
+volatile uint16_t tick_sync_time;
+
 ISR(RTC_CNT_vect)
 {
 
@@ -52,23 +65,45 @@ ISR(RTC_CNT_vect)
 
 ISR(TCA0_OVF_vect){
 	
-	static uint8_t counter = 0;
-
-	if(counter == 0){
+	static uint8_t duty[2];
+
+	if(pwm_counter == 0){
+		// Take a frame committed by the I2C host
+		framebuffer_present();
+		
+		// Latch this frame's duty cycles, scaled by the brightness ceiling
+		// and mapped from perceptual levels. Mid render, keep the last ones.
+		if(render_busy){
+			render_overruns++;
+		}
+		else{
+			duty[0] = lut_gamma(((uint16_t)LED_PWM[0] * (LED_CEILING + 1)) >> 8);
+			duty[1] = lut_gamma(((uint16_t)LED_PWM[1] * (LED_CEILING + 1)) >> 8);
+		}
+		
+		// Time for the main loop to render the next frame
+		if(++render_periods == RENDER_DIVIDER){
+			render_periods = 0;
+			if(render_due){
+				render_overruns++;
+			}
+			render_due = true;
+		}
+		
 		// Set all LEDs high
 		LED_RIGHT_set_level(true);
 		LED_LEFT_set_level(true);
 	}
 
 	// Determine if each LED needs to turn off
-	if(LED_PWM[0] <= counter){
+	if(duty[0] <= pwm_counter){
 		LED_RIGHT_set_level(false);
 	}
-	if(LED_PWM[1] <= counter){
+	if(duty[1] <= pwm_counter){
 		LED_LEFT_set_level(false);
 	}
 	
-	counter++;
+	pwm_counter++;
 
 	/* The interrupt flag has to be cleared manually */
 	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_OVF_bm;
@@ -80,10 +115,19 @@ ISR(TCA0_CMP0_vect){
 	TCA0.SINGLE.INTFLAGS = TCA_SINGLE_CMP0_bm;
 }
 
-
-// Fires every 100ms
+// Fires every 1ms
 ISR(TCB0_INT_vect){
-		timeTicks++;
+		if(tick_synced){
+			// Held off, the I2C ISR could sync again half way through the copy
+			cpu_irq_disable();
+			timeTicks = tick_sync_time;
+			tick_synced = false;
+			cpu_irq_enable();
+		}
+		else{
+			timeTicks++;
+		}
+		haptic_tick();
 
 	/**
 	 * The interrupt flag is cleared by writing 1 to it, or when the Capture register
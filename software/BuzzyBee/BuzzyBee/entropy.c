@@ -0,0 +1,61 @@
+/* BuzzyBee random seed, see entropy.h */
+
+#include <atmel_start.h>
+#include <util/crc16.h>
+
+#include "entropy.h"
+#include "prng.h"
+
+// Clock phase samples, each waits for an RTC count of about 30 us
+#define ENTROPY_JITTER_SAMPLES 4
+
+extern uint16_t touch_acq_signals_raw[DEF_NUM_CHANNELS];
+
+/*============================================================================
+void entropy_init(void)
+------------------------------------------------------------------------------
+Purpose: Seed the PRNG from the serial number and clock jitter
+Input  : none
+Output : none
+Notes  : Called at boot, once the RTC runs. Takes about 120 us.
+============================================================================*/
+void entropy_init(void)
+{
+	uint16_t       hash   = 0xFFFF;
+	const uint8_t *serial = (const uint8_t *)&SIGROW.SERNUM0;
+
+	for (uint8_t i = 0; i < 10; i++) {
+		hash = _crc_ccitt_update(hash, serial[i]);
+	}
+
+	// CPU cycles to the next RTC count: the two oscillators drift
+	// independently, so the low bits differ every time
+	for (uint8_t i = 0; i < ENTROPY_JITTER_SAMPLES; i++) {
+		uint8_t  count = 0;
+		uint16_t rtc   = RTC.CNT;
+		while (RTC.CNT == rtc) {
+			count++;
+		}
+		hash = _crc_ccitt_update(hash, count);
+	}
+
+	prng_seed(hash);
+}
+
+/*============================================================================
+void entropy_add_touch(void)
+------------------------------------------------------------------------------
+Purpose: Mix the PTC's raw signals into the PRNG
+Input  : none
+Output : none
+Notes  : Called from the main loop once a measurement is done
+============================================================================*/
+void entropy_add_touch(void)
+{
+	uint16_t hash = prng_state;
+
+	for (uint8_t i = 0; i < DEF_NUM_CHANNELS; i++) {
+		hash = _crc_ccitt_update(hash, touch_acq_signals_raw[i]);
+	}
+	prng_seed(hash);
+}
@@ -0,0 +1,18 @@
+/* BuzzyBee random seed
+ *
+ * Seeds prng.h differently on every board and every power up, so badges in
+ * the same room do not twinkle in unison. At boot the seed hashes the SIGROW
+ * serial number, which differs per chip, and the phase between the CPU clock
+ * and the 32kHz oscillator that runs the RTC, which differs per power up. The
+ * LSB noise of the first PTC measurement is mixed in once touch is running.
+ *
+ * A general call sync reseeds from the broadcast, so synced boards still
+ * agree; main() then skips the PTC mix.
+ */
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+void entropy_init(void);
+void entropy_add_touch(void);
+
+#endif // ENTROPY_H
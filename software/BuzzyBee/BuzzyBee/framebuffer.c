@@ -0,0 +1,33 @@
+/* BuzzyBee streaming framebuffer, see framebuffer.h */
+
+#include <atmel_start.h>
+
+#include "framebuffer.h"
+
+volatile uint8_t fb_back[FB_SIZE];
+volatile uint8_t fb_pending[FB_SIZE];
+volatile bool fb_ready;
+volatile uint16_t fb_fps;
+volatile uint8_t fb_dropped;
+volatile uint16_t fb_frames;
+
+static uint16_t fb_second;
+
+/*============================================================================
+void framebuffer_update(void)
+------------------------------------------------------------------------------
+Purpose: Work out the frame rate once a second
+Input  : none
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void framebuffer_update(void)
+{
+	cpu_irq_disable();
+	if ((uint16_t)(timeTicks - fb_second) >= 1000) {
+		fb_second += 1000;
+		fb_fps    = fb_frames;
+		fb_frames = 0;
+	}
+	cpu_irq_enable();
+}
@@ -0,0 +1,88 @@
+/* BuzzyBee streaming framebuffer
+ *
+ * In MODE_STREAM the host writes whole frames into fb_back over I2C and
+ * commits them. A committed frame waits in fb_pending until the PWM ISR takes
+ * it at the start of the next PWM period, so a period never shows half of one
+ * frame and half of the next, and the host can fill fb_back again straight
+ * away. A frame committed before the previous one was shown replaces it and
+ * is counted as dropped.
+ */
+#ifndef FRAMEBUFFER_H
+#define FRAMEBUFFER_H
+
+#include <atmel_start_pins.h>
+#include <stdbool.h>
+
+#include "buzzybee.h"
+#include "haptic.h"
+
+// Frame layout
+enum {
+	FB_LED0, // LED_RIGHT level
+	FB_LED1, // LED_LEFT level
+	FB_VIBE, // Vibration motor level
+	FB_SIZE
+};
+
+extern volatile uint8_t fb_back[FB_SIZE];
+extern volatile uint8_t fb_pending[FB_SIZE];
+extern volatile bool fb_ready;
+// Frames shown in the last second
+extern volatile uint16_t fb_fps;
+// Frames replaced before they were shown, wraps
+extern volatile uint8_t fb_dropped;
+extern volatile uint16_t fb_frames;
+
+void framebuffer_update(void);
+
+/*============================================================================
+static inline void framebuffer_commit(void)
+------------------------------------------------------------------------------
+Purpose: Queue the frame in fb_back for the next PWM period
+Input  : none
+Output : none
+Notes  : Called from the I2C ISR, which the PWM ISR cannot interrupt, so the
+         copy is never seen half done. Ignored outside MODE_STREAM.
+============================================================================*/
+static inline __attribute__((always_inline)) void framebuffer_commit(void)
+{
+	if (run_mode != MODE_STREAM) {
+		return;
+	}
+	if (fb_ready) {
+		fb_dropped++;
+	}
+	// Unrolled, the ISR's per-byte cost is counted with no loops in it
+	fb_pending[FB_LED0] = fb_back[FB_LED0];
+	fb_pending[FB_LED1] = fb_back[FB_LED1];
+	fb_pending[FB_VIBE] = fb_back[FB_VIBE];
+	fb_ready = true;
+}
+
+/*============================================================================
+static inline void framebuffer_present(void)
+------------------------------------------------------------------------------
+Purpose: Show the committed frame, if there is one
+Input  : none
+Output : none
+Notes  : Called from the PWM ISR before it latches a period's duty cycles.
+         Inline so the 78kHz ISR does not pay for a call. Interrupts are
+         held off for the copy, as the level 1 I2C ISR commits frames.
+============================================================================*/
+static inline void framebuffer_present(void)
+{
+	if (fb_ready) {
+		uint8_t sreg = SREG;
+		cpu_irq_disable();
+		LED_PWM[0] = fb_pending[FB_LED0];
+		LED_PWM[1] = fb_pending[FB_LED1];
+		// Left for haptic_tick(), a call would cost every PWM ISR its registers
+		haptic_stream_level = fb_pending[FB_VIBE];
+		haptic_streamed     = true;
+		fb_ready = false;
+		SREG     = sreg;
+		fb_frames++;
+	}
+}
+
+#endif // FRAMEBUFFER_H
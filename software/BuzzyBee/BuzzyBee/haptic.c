@@ -0,0 +1,226 @@
+/* BuzzyBee haptics, see haptic.h */
+
+#include <atmel_start.h>
+#include <avr/pgmspace.h>
+#include <buzzybee_config.h>
+
+#include "haptic.h"
+
+static const haptic_step_t haptic_pulses[] PROGMEM = {
+	{255, HAPTIC_MS(52)},
+	{0, HAPTIC_MS(52)},
+	{255, HAPTIC_MS(52)},
+	{0, HAPTIC_MS(52)},
+	{255, HAPTIC_MS(52)},
+	HAPTIC_END
+};
+
+static const haptic_step_t haptic_click[] PROGMEM = {
+	{255, HAPTIC_MS(20)},
+	HAPTIC_END
+};
+
+static const haptic_step_t haptic_swell[] PROGMEM = {
+	{255, HAPTIC_RAMP | HAPTIC_MS(400)},
+	{0, HAPTIC_RAMP | HAPTIC_MS(400)},
+	HAPTIC_END
+};
+
+// A strong beat and a weaker one, then a rest
+static const haptic_step_t haptic_heartbeat[] PROGMEM = {
+	{255, HAPTIC_MS(60)},
+	{0, HAPTIC_MS(100)},
+	{160, HAPTIC_MS(80)},
+	{0, HAPTIC_MS(500)},
+	{255, HAPTIC_MS(60)},
+	{0, HAPTIC_MS(100)},
+	{160, HAPTIC_MS(80)},
+	HAPTIC_END
+};
+
+// Indexed by HAPTIC_x
+static const haptic_step_t *const haptic_patterns[] PROGMEM = {
+	[HAPTIC_PULSES]    = haptic_pulses,
+	[HAPTIC_CLICK]     = haptic_click,
+	[HAPTIC_SWELL]     = haptic_swell,
+	[HAPTIC_HEARTBEAT] = haptic_heartbeat,
+};
+
+volatile uint8_t haptic_stream_level;
+volatile bool haptic_streamed;
+
+// Next step to play, NULL when no pattern is
+static const haptic_step_t *haptic_next;
+// Ticks left in the current step
+static uint8_t haptic_time;
+static uint8_t haptic_ms;
+static uint8_t haptic_target;
+// Level and ramp slope in fixed point, 7 bits of fraction
+static uint16_t haptic_out;
+static int16_t haptic_slope;
+// Level the motor settles at, after any kick or brake
+static uint8_t haptic_level;
+// ms left of a kick or brake
+static uint8_t haptic_phase;
+
+/*============================================================================
+static void haptic_pwm(uint8_t level)
+------------------------------------------------------------------------------
+Purpose: Set the motor's PWM duty cycle
+Input  : level: 0 off to 255 full on
+Output : none
+Notes  : Takes effect at the next PWM period. Interrupts are held off, as
+         the level 1 I2C ISR also writes TCA0's 16 bit registers through
+         the same TEMP register.
+============================================================================*/
+static void haptic_pwm(uint8_t level)
+{
+	uint8_t sreg = SREG;
+
+	cpu_irq_disable();
+	// A compare above PER never clears the output, so 255 is full on
+	TCA0.SINGLE.CMP1BUF = (level == 255) ? 0x100 : level;
+	SREG = sreg;
+}
+
+/*============================================================================
+static void haptic_drive(uint8_t level)
+------------------------------------------------------------------------------
+Purpose: Move the motor to a level
+Input  : level: 0 off to 255 full on
+Output : none
+Notes  : A rise is kicked at full duty and a fall starts with the motor
+         off, for a time in proportion to the change, so the motor gets to
+         its new speed sooner. Steps of a few levels, as in a ramp, take
+         no time, so ramps stay smooth.
+============================================================================*/
+static void haptic_drive(uint8_t level)
+{
+	uint8_t sreg = SREG;
+
+	cpu_irq_disable();
+	if (level > haptic_level) {
+		haptic_phase = ((uint16_t)(level - haptic_level) * HAPTIC_KICK_MS) >> 8;
+		haptic_pwm(haptic_phase ? 255 : level);
+	} else if (level < haptic_level) {
+		haptic_phase = ((uint16_t)(haptic_level - level) * HAPTIC_BRAKE_MS) >> 8;
+		haptic_pwm(haptic_phase ? 0 : level);
+	}
+	haptic_level = level;
+	SREG         = sreg;
+}
+
+/*============================================================================
+void haptic_init(void)
+------------------------------------------------------------------------------
+Purpose: Hand PB4 to TCA0 and stop the motor
+Input  : none
+Output : none
+Notes  : Call after TIMER_0_init(). The PWM ISR still runs off the
+         overflow, once every period as in normal mode.
+============================================================================*/
+void haptic_init(void)
+{
+	haptic_pwm(0);
+	PORTMUX.CTRLC |= PORTMUX_TCA01_bm;
+	TCA0.SINGLE.CTRLB = (TCA0.SINGLE.CTRLB & ~TCA_SINGLE_WGMODE_gm) | TCA_SINGLE_CMP1EN_bm
+	                    | TCA_SINGLE_WGMODE_SINGLESLOPE_gc;
+}
+
+/*============================================================================
+void haptic_play(uint8_t pattern)
+------------------------------------------------------------------------------
+Purpose: Start a pattern
+Input  : pattern: HAPTIC_x, HAPTIC_COUNT or above stops the motor
+Output : none
+Notes  : Replaces the pattern or level playing, returns straight away.
+         Safe from ISRs.
+============================================================================*/
+void haptic_play(uint8_t pattern)
+{
+	if (pattern >= HAPTIC_COUNT) {
+		haptic_set(0);
+		return;
+	}
+
+	uint8_t sreg = SREG;
+
+	cpu_irq_disable();
+	haptic_next = pgm_read_ptr(&haptic_patterns[pattern]);
+	haptic_time = 0;
+	// First step on the next tick
+	haptic_ms = HAPTIC_TICK_MS - 1;
+	SREG      = sreg;
+}
+
+/*============================================================================
+void haptic_set(uint8_t level)
+------------------------------------------------------------------------------
+Purpose: Hold the motor at a level
+Input  : level: 0 off to 255 full on
+Output : none
+Notes  : Stops any pattern. Safe from ISRs.
+============================================================================*/
+void haptic_set(uint8_t level)
+{
+	uint8_t sreg = SREG;
+
+	cpu_irq_disable();
+	haptic_next   = NULL;
+	haptic_target = level;
+	haptic_out    = (uint16_t)level << 7;
+	haptic_drive(level);
+	SREG = sreg;
+}
+
+/*============================================================================
+void haptic_tick(void)
+------------------------------------------------------------------------------
+Purpose: Play the pattern on
+Input  : none
+Output : none
+Notes  : Called from the millisecond timer ISR. Takes a streamed level,
+         ends kicks and brakes, starts the next step once the current one
+         has run its time, and moves ramps on every tick.
+============================================================================*/
+void haptic_tick(void)
+{
+	haptic_step_t step;
+
+	if (haptic_streamed) {
+		haptic_streamed = false;
+		haptic_set(haptic_stream_level);
+	}
+
+	if (haptic_phase && --haptic_phase == 0) {
+		haptic_pwm(haptic_level);
+	}
+
+	if (haptic_next == NULL || ++haptic_ms < HAPTIC_TICK_MS) {
+		return;
+	}
+	haptic_ms = 0;
+
+	if (haptic_time) {
+		// Land a ramp on its level, whatever the rounding
+		haptic_out = (--haptic_time) ? haptic_out + haptic_slope : (uint16_t)haptic_target << 7;
+		if (haptic_slope) {
+			haptic_drive(haptic_out >> 7);
+		}
+		if (haptic_time) {
+			return;
+		}
+	}
+
+	memcpy_P(&step, haptic_next, sizeof(step));
+	haptic_target = step.level;
+	haptic_time   = step.time & ~HAPTIC_RAMP;
+	if ((step.time & HAPTIC_RAMP) && haptic_time) {
+		haptic_slope = ((int16_t)((uint16_t)step.level << 7) - (int16_t)haptic_out) / haptic_time;
+	} else {
+		haptic_slope = 0;
+		haptic_out   = (uint16_t)step.level << 7;
+		haptic_drive(step.level);
+	}
+	haptic_next = haptic_time ? haptic_next + 1 : NULL;
+}
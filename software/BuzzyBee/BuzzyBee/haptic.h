@@ -0,0 +1,62 @@
+/* BuzzyBee haptics
+ *
+ * The vibration motor on PB4 runs from TCA0 compare channel 1, on its
+ * alternate pin, in single slope PWM at the LED PWM timer's 78 kHz, so its
+ * level sets the motor's intensity instead of only on or off.
+ *
+ * Patterns are tables of steps in flash. A step holds a level for a time,
+ * or with HAPTIC_RAMP moves to it in a straight line over that time. The
+ * millisecond timer ISR plays them with haptic_tick(), so a pattern runs on
+ * while the main loop scans the keys and renders, and playing one never
+ * blocks. A step without a time, HAPTIC_END, sets its level and ends the
+ * pattern.
+ *
+ * haptic_set() holds a level until the next call, stopping any pattern. The
+ * butt key, the VM and streamed frames drive the motor that way.
+ *
+ * A small ERM motor takes tens of ms to spin up or down, so a change of
+ * level starts with a kick at full duty, or with a brake, for a time in
+ * proportion to the change, HAPTIC_KICK_MS or HAPTIC_BRAKE_MS for the full
+ * range, set per motor in buzzybee_config.h. The motor is switched by one
+ * low side transistor and cannot be driven backwards, so the brake is the
+ * motor left off to coast: it hurries a fall to a lower level along, and
+ * a stop ends as it always did. Likewise a rise to full gains nothing from
+ * the kick. software/tools/haptic_sim runs both through a motor model.
+ */
+#ifndef HAPTIC_H
+#define HAPTIC_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#define HAPTIC_TICK_MS 4
+// Step time from ms, up to 508
+#define HAPTIC_MS(ms) ((ms) / HAPTIC_TICK_MS)
+#define HAPTIC_RAMP 0x80
+#define HAPTIC_END {0, 0}
+
+typedef struct {
+	uint8_t level; // Motor level, 255 is full on
+	uint8_t time;  // In ticks, with HAPTIC_RAMP to ramp to the level
+} haptic_step_t;
+
+// Patterns
+enum {
+	HAPTIC_PULSES,    // Three short buzzes, played at power up
+	HAPTIC_CLICK,     // One short tap
+	HAPTIC_SWELL,     // Ramp up and back down
+	HAPTIC_HEARTBEAT, // Two lub-dubs
+	HAPTIC_COUNT
+};
+
+// Motor level of the last streamed frame, set by the PWM ISR and applied on
+// the next tick, see framebuffer.h
+extern volatile uint8_t haptic_stream_level;
+extern volatile bool haptic_streamed;
+
+void haptic_init(void);
+void haptic_play(uint8_t pattern);
+void haptic_set(uint8_t level);
+void haptic_tick(void);
+
+#endif // HAPTIC_H
@@ -0,0 +1,156 @@
+/* BuzzyBee touch event publishing as I2C master, see i2c_publish.h */
+
+#include <atmel_start.h>
+#include <buzzybee_config.h>
+
+#include "buzzybee.h"
+#include "i2c_publish.h"
+
+#if I2C_PUBLISH_ENABLE == 1
+
+#define I2C_PUBLISH_BAUD ((F_CPU / (2 * (uint32_t)I2C_PUBLISH_FREQUENCY)) - 5)
+
+enum {
+	PUBLISH_IDLE,
+	PUBLISH_BUSY, // Transaction running in the ISR
+	PUBLISH_DONE, // Record sent, or dropped by the peer
+	PUBLISH_LOST  // Lost arbitration, retry after a backoff
+};
+
+volatile uint8_t i2c_publish_sent;
+// Arbitration losses, wraps
+volatile uint8_t i2c_publish_lost;
+// Records dropped after I2C_PUBLISH_RETRIES or a NACK, or on a full queue, wraps
+volatile uint8_t i2c_publish_dropped;
+
+static volatile uint8_t i2c_publish_state;
+static uint8_t          i2c_publish_record[I2C_PUBLISH_RECORD_SIZE];
+static volatile uint8_t i2c_publish_index;
+
+static uint8_t  i2c_publish_queue[I2C_PUBLISH_QUEUE_SIZE];
+static uint8_t  i2c_publish_head;
+static uint8_t  i2c_publish_count;
+static uint8_t  i2c_publish_sequence;
+static uint8_t  i2c_publish_attempts;
+static uint16_t i2c_publish_retry_at;
+
+/*============================================================================
+void i2c_publish_init(void)
+------------------------------------------------------------------------------
+Purpose: Enable the TWI0 master next to the slave
+Input  : none
+Output : none
+Notes  :
+============================================================================*/
+void i2c_publish_init(void)
+{
+	TWI0.MBAUD   = I2C_PUBLISH_BAUD;
+	TWI0.MCTRLA  = TWI_RIEN_bm | TWI_WIEN_bm | TWI_TIMEOUT_200US_gc | TWI_ENABLE_bm;
+	TWI0.MSTATUS = TWI_BUSSTATE_IDLE_gc;
+}
+
+/*============================================================================
+void i2c_publish(uint8_t event)
+------------------------------------------------------------------------------
+Purpose: Queue a touch event for the peer
+Input  : event: touch event
+Output : none
+Notes  : Called from the main loop. A full queue drops the event.
+============================================================================*/
+void i2c_publish(uint8_t event)
+{
+	if (i2c_publish_count == I2C_PUBLISH_QUEUE_SIZE) {
+		i2c_publish_dropped++;
+		return;
+	}
+	i2c_publish_queue[(i2c_publish_head + i2c_publish_count++) & (I2C_PUBLISH_QUEUE_SIZE - 1)] = event;
+}
+
+static void i2c_publish_next(void)
+{
+	i2c_publish_head     = (i2c_publish_head + 1) & (I2C_PUBLISH_QUEUE_SIZE - 1);
+	i2c_publish_count    = i2c_publish_count - 1;
+	i2c_publish_attempts = 0;
+	i2c_publish_state    = PUBLISH_IDLE;
+}
+
+/*============================================================================
+void i2c_publish_update(void)
+------------------------------------------------------------------------------
+Purpose: Start the next record once the bus is free and any backoff is over
+Input  : none
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void i2c_publish_update(void)
+{
+	uint16_t now;
+
+	cpu_irq_disable();
+	now = timeTicks;
+	cpu_irq_enable();
+
+	switch (i2c_publish_state) {
+	case PUBLISH_DONE:
+		i2c_publish_next();
+		break;
+	case PUBLISH_LOST:
+		i2c_publish_lost++;
+		if (++i2c_publish_attempts == I2C_PUBLISH_RETRIES) {
+			i2c_publish_dropped++;
+			i2c_publish_next();
+			break;
+		}
+		// Random backoff, so boards that collided do not collide again
+		i2c_publish_retry_at = now + 1 + (TCB0.CNT & ((2 << i2c_publish_attempts) - 1));
+		i2c_publish_state    = PUBLISH_IDLE;
+		break;
+	case PUBLISH_IDLE:
+		if (i2c_publish_count == 0 || (int16_t)(now - i2c_publish_retry_at) < 0
+		    || (TWI0.MSTATUS & TWI_BUSSTATE_gm) != TWI_BUSSTATE_IDLE_gc) {
+			break;
+		}
+		i2c_publish_record[0] = I2C_SLAVE_ADDRESS;
+		i2c_publish_record[1] = i2c_publish_queue[i2c_publish_head];
+		i2c_publish_record[2] = i2c_publish_sequence++;
+		i2c_publish_index     = 0;
+		i2c_publish_state     = PUBLISH_BUSY;
+		TWI0.MADDR            = I2C_PUBLISH_ADDRESS << 1;
+		break;
+	}
+}
+
+/*============================================================================
+ISR(TWI0_TWIM_vect)
+------------------------------------------------------------------------------
+Purpose: Send the record, one byte per interrupt
+Input  : none
+Output : none
+Notes  :
+============================================================================*/
+ISR(TWI0_TWIM_vect)
+{
+	uint8_t status = TWI0.MSTATUS;
+
+	if (status & (TWI_ARBLOST_bm | TWI_BUSERR_bm)) {
+		// Another master won the bus, the hardware has already let go of it
+		TWI0.MSTATUS      = TWI_ARBLOST_bm | TWI_BUSERR_bm | TWI_WIF_bm | TWI_RIF_bm;
+		i2c_publish_state = PUBLISH_LOST;
+		return;
+	}
+
+	if ((status & TWI_RXACK_bm) || i2c_publish_index == I2C_PUBLISH_RECORD_SIZE) {
+		if (status & TWI_RXACK_bm) {
+			i2c_publish_dropped++;
+		} else {
+			i2c_publish_sent++;
+		}
+		TWI0.MCTRLB       = TWI_MCMD_STOP_gc;
+		i2c_publish_state = PUBLISH_DONE;
+		return;
+	}
+
+	TWI0.MDATA = i2c_publish_record[i2c_publish_index++];
+}
+
+#endif
@@ -0,0 +1,30 @@
+/* BuzzyBee touch event publishing as I2C master
+ *
+ * With I2C_PUBLISH_ENABLE, touch events are written to the peer at
+ * I2C_PUBLISH_ADDRESS as they happen, as the record
+ *
+ *   I2C_SLAVE_ADDRESS event sequence
+ *
+ * where event is coded as in touch_events.h. TWI0 keeps answering as a slave
+ * meanwhile. A record that loses arbitration to another master is retried
+ * after a random backoff that doubles with every attempt, up to
+ * I2C_PUBLISH_RETRIES; a peer that does not acknowledge drops it.
+ */
+#ifndef I2C_PUBLISH_H
+#define I2C_PUBLISH_H
+
+#include <stdint.h>
+
+// Must be a power of 2
+#define I2C_PUBLISH_QUEUE_SIZE 4
+#define I2C_PUBLISH_RECORD_SIZE 3
+
+extern volatile uint8_t i2c_publish_sent;
+extern volatile uint8_t i2c_publish_lost;
+extern volatile uint8_t i2c_publish_dropped;
+
+void i2c_publish_init(void);
+void i2c_publish(uint8_t event);
+void i2c_publish_update(void);
+
+#endif // I2C_PUBLISH_H
@@ -0,0 +1,324 @@
+/* BuzzyBee I2C register map, see i2c_registers.h
+ *
+ * Every register is a pointer into the live variable it exposes, kept in
+ * flash, so a read is served straight from the source without keeping a
+ * shadow copy up to date. Everything runs from the TWI0 slave interrupt,
+ * which replaces the callback dispatch of the generic driver.
+ */
+
+#include <atmel_start.h>
+#include <avr/pgmspace.h>
+#include <avr/xmega.h>
+#include <buzzybee_config.h>
+
+#include "buzzybee.h"
+#include "framebuffer.h"
+#include "i2c_publish.h"
+#include "i2c_registers.h"
+#include "mailbox.h"
+#include "render.h"
+#include "touch_events.h"
+#include "vm.h"
+
+extern qtm_touch_key_data_t qtlib_key_data_set1[];
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+extern uint8_t sensor_health[];
+extern uint8_t sensor_fault_count[];
+#else
+static const uint8_t i2c_health_disabled = SENSOR_HEALTH_DISABLED;
+static const uint8_t i2c_no_faults       = 0;
+#endif
+
+static const uint8_t i2c_id = I2C_ID;
+static const uint8_t i2c_version = I2C_VERSION;
+
+static volatile uint8_t i2c_transactions;
+static volatile uint8_t i2c_sync_count;
+static volatile uint8_t i2c_errors;
+// Backing byte for registers whose writes trigger an action
+static volatile uint8_t i2c_trigger;
+
+static volatile uint8_t *const i2c_rw_map[I2C_REG_RW_END] PROGMEM = {
+	[I2C_REG_MODE]    = (volatile uint8_t *)&run_mode,
+	[I2C_REG_LED0]    = &LED_PWM[0],
+	[I2C_REG_LED1]    = &LED_PWM[1],
+	[I2C_REG_CEILING] = &LED_CEILING,
+	[I2C_REG_FB_LED0]   = &fb_back[FB_LED0],
+	[I2C_REG_FB_LED1]   = &fb_back[FB_LED1],
+	[I2C_REG_FB_VIBE]   = &fb_back[FB_VIBE],
+	[I2C_REG_FB_COMMIT] = &i2c_trigger,
+#if VM_ENABLE == 1
+	[I2C_REG_PROG_ADDR] = &vm_load_addr,
+	[I2C_REG_PROG_DATA] = &i2c_trigger,
+	[I2C_REG_PROG_CTRL] = &i2c_trigger,
+#endif
+	[I2C_REG_BOOT]      = &i2c_trigger,
+	[I2C_REG_CMD_ARG0]  = &mailbox_arg[0],
+	[I2C_REG_CMD_ARG1]  = &mailbox_arg[1],
+	[I2C_REG_CMD]       = &i2c_trigger,
+};
+
+static volatile uint8_t *const i2c_ro_map[I2C_REG_RO_END - I2C_REG_RO_BASE] PROGMEM = {
+	[I2C_REG_ID - I2C_REG_RO_BASE]         = (volatile uint8_t *)&i2c_id,
+	[I2C_REG_VERSION - I2C_REG_RO_BASE]    = (volatile uint8_t *)&i2c_version,
+	[I2C_REG_KEY0_STATE - I2C_REG_RO_BASE] = &qtlib_key_data_set1[0].sensor_state,
+	[I2C_REG_KEY1_STATE - I2C_REG_RO_BASE] = &qtlib_key_data_set1[1].sensor_state,
+	[I2C_REG_KEY0_COUNT - I2C_REG_RO_BASE] = &touch_count[0],
+	[I2C_REG_KEY1_COUNT - I2C_REG_RO_BASE] = &touch_count[1],
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+	[I2C_REG_KEY0_HEALTH - I2C_REG_RO_BASE] = &sensor_health[0],
+	[I2C_REG_KEY1_HEALTH - I2C_REG_RO_BASE] = &sensor_health[1],
+	[I2C_REG_KEY0_FAULTS - I2C_REG_RO_BASE] = &sensor_fault_count[0],
+	[I2C_REG_KEY1_FAULTS - I2C_REG_RO_BASE] = &sensor_fault_count[1],
+#else
+	[I2C_REG_KEY0_HEALTH - I2C_REG_RO_BASE] = (volatile uint8_t *)&i2c_health_disabled,
+	[I2C_REG_KEY1_HEALTH - I2C_REG_RO_BASE] = (volatile uint8_t *)&i2c_health_disabled,
+	[I2C_REG_KEY0_FAULTS - I2C_REG_RO_BASE] = (volatile uint8_t *)&i2c_no_faults,
+	[I2C_REG_KEY1_FAULTS - I2C_REG_RO_BASE] = (volatile uint8_t *)&i2c_no_faults,
+#endif
+	[I2C_REG_TICKS_L - I2C_REG_RO_BASE]      = (volatile uint8_t *)&timeTicks,
+	[I2C_REG_TICKS_H - I2C_REG_RO_BASE]      = (volatile uint8_t *)&timeTicks + 1,
+	[I2C_REG_TRANSACTIONS - I2C_REG_RO_BASE] = &i2c_transactions,
+	[I2C_REG_FB_FPS_L - I2C_REG_RO_BASE]     = (volatile uint8_t *)&fb_fps,
+	[I2C_REG_FB_FPS_H - I2C_REG_RO_BASE]     = (volatile uint8_t *)&fb_fps + 1,
+	[I2C_REG_FB_DROPPED - I2C_REG_RO_BASE]   = &fb_dropped,
+#if VM_ENABLE == 1
+	[I2C_REG_PROG_STATE - I2C_REG_RO_BASE]   = &vm_state,
+	[I2C_REG_PROG_PC - I2C_REG_RO_BASE]      = &vm_pc,
+#endif
+	[I2C_REG_NVM_STATUS - I2C_REG_RO_BASE]   = &NVMCTRL.STATUS,
+	[I2C_REG_EVENT - I2C_REG_RO_BASE]          = &touch_event,
+	[I2C_REG_EVENT_COUNT - I2C_REG_RO_BASE]    = &touch_event_count,
+	[I2C_REG_EVENT_OVERFLOW - I2C_REG_RO_BASE] = &touch_event_overflow,
+	[I2C_REG_SYNC_COUNT - I2C_REG_RO_BASE]     = &i2c_sync_count,
+	[I2C_REG_ERRORS - I2C_REG_RO_BASE]         = &i2c_errors,
+	[I2C_REG_CMD_STATUS - I2C_REG_RO_BASE]     = &mailbox_status,
+	[I2C_REG_CMD_DONE - I2C_REG_RO_BASE]       = &mailbox_done,
+	[I2C_REG_CMD_PENDING - I2C_REG_RO_BASE]    = &mailbox_pending,
+#if I2C_PUBLISH_ENABLE == 1
+	[I2C_REG_PUBLISH_SENT - I2C_REG_RO_BASE]    = &i2c_publish_sent,
+	[I2C_REG_PUBLISH_LOST - I2C_REG_RO_BASE]    = &i2c_publish_lost,
+	[I2C_REG_PUBLISH_DROPPED - I2C_REG_RO_BASE] = &i2c_publish_dropped,
+#endif
+	[I2C_REG_RENDER_TIME_L - I2C_REG_RO_BASE] = (volatile uint8_t *)&render_time,
+	[I2C_REG_RENDER_TIME_H - I2C_REG_RO_BASE] = (volatile uint8_t *)&render_time + 1,
+	[I2C_REG_RENDER_OVERRUNS - I2C_REG_RO_BASE] = &render_overruns,
+	[I2C_REG_RENDER_BLEND_L - I2C_REG_RO_BASE]  = (volatile uint8_t *)&render_time_blend,
+	[I2C_REG_RENDER_BLEND_H - I2C_REG_RO_BASE]  = (volatile uint8_t *)&render_time_blend + 1,
+};
+
+static uint8_t i2c_pointer;
+// Set at the start of every transaction, the next written byte is the register pointer
+static bool i2c_pointer_pending;
+// Set at the start of every transaction, until the first byte has been read
+static bool i2c_first_read;
+#if I2C_GENERAL_CALL_SYNC == 1
+// Byte count in a general call transaction, 0xFF once it is not a sync
+static uint8_t i2c_general_call;
+static uint8_t i2c_sync_time_l;
+#endif
+
+/*============================================================================
+static inline volatile uint8_t *i2c_register(uint8_t reg)
+------------------------------------------------------------------------------
+Purpose: Look up the variable behind a register
+Input  : reg: register address
+Output : pointer to the register's byte, NULL if there is none
+Notes  :
+============================================================================*/
+static inline __attribute__((always_inline)) volatile uint8_t *i2c_register(uint8_t reg)
+{
+	if (reg < I2C_REG_RW_END) {
+		return (volatile uint8_t *)pgm_read_ptr(&i2c_rw_map[reg]);
+	}
+	if (reg >= I2C_REG_RO_BASE && reg < I2C_REG_RO_END) {
+		return (volatile uint8_t *)pgm_read_ptr(&i2c_ro_map[reg - I2C_REG_RO_BASE]);
+	}
+	return NULL;
+}
+
+#if I2C_GENERAL_CALL_SYNC == 1
+/*============================================================================
+static inline void i2c_general_call_write(uint8_t data)
+------------------------------------------------------------------------------
+Purpose: Take a byte of a general call write, syncing on the last byte of
+         I2C_GC_SYNC time_l time_h
+Input  : data: received byte
+Output : none
+Notes  : Every board sees the last byte at the same SCL edge, so the clocks
+         line up to within the ISR latency
+============================================================================*/
+static inline void i2c_general_call_write(uint8_t data)
+{
+	switch (i2c_general_call) {
+	case 1:
+		if (data != I2C_GC_SYNC) {
+			i2c_general_call = 0xFF;
+			return;
+		}
+		break;
+	case 2:
+		i2c_sync_time_l = data;
+		break;
+	case 3:
+		animation_sync_time = ((uint16_t)data << 8) | i2c_sync_time_l;
+		pwm_sync(animation_sync_time);
+		animation_synced    = true;
+		i2c_sync_count++;
+		break;
+	default:
+		return;
+	}
+	i2c_general_call++;
+}
+#endif
+
+/*============================================================================
+ISR(TWI0_TWIS_vect)
+------------------------------------------------------------------------------
+Purpose: TWI0 slave state machine serving the register map
+Input  : none
+Output : none
+Notes  : Runs as the level 1 interrupt, so it preempts the PWM and touch ISRs.
+         Everything on the per-byte path is inlined, and the bus is released
+         as soon as the byte is handled: a received byte is acknowledged
+         before its side effects run. Collisions and bus errors drop the
+         transaction and count an error, the master retries.
+============================================================================*/
+ISR(TWI0_TWIS_vect)
+{
+	uint8_t status = TWI0.SSTATUS;
+
+	if (status & (TWI_COLL_bm | TWI_BUSERR_bm)) {
+		TWI0.SSTATUS = TWI_COLL_bm | TWI_BUSERR_bm;
+		TWI0.SCTRLB  = TWI_SCMD_COMPTRANS_gc;
+		i2c_errors++;
+		return;
+	}
+
+	if (status & TWI_APIF_bm) {
+		if (status & TWI_AP_bm) {
+			// Addressed, a new transaction
+#if I2C_GENERAL_CALL_SYNC == 1
+			// SDATA holds the received address, 0 for a general call
+			i2c_general_call = (TWI0.SDATA >> 1) ? 0 : 1;
+#endif
+			i2c_first_read      = true;
+			i2c_pointer_pending = true;
+			TWI0.SCTRLB         = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			i2c_transactions++;
+		} else {
+			// Stop
+			TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+		}
+		return;
+	}
+
+	if (!(status & TWI_DIF_bm)) {
+		return;
+	}
+
+	if (status & TWI_DIR_bm) {
+		// Master reads. RXACK still holds the previous transaction's last ACK
+		// until the master has acknowledged the first byte.
+		if (!i2c_first_read && (status & TWI_RXACK_bm)) {
+			// Master NACKed the last byte, transaction is over
+			TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+			return;
+		}
+		i2c_first_read = false;
+
+		volatile uint8_t *reg = i2c_register(i2c_pointer);
+
+		TWI0.SDATA  = reg ? *reg : 0xFF;
+		TWI0.SCTRLB = TWI_SCMD_RESPONSE_gc;
+		if (i2c_pointer == I2C_REG_EVENT) {
+			// Reading an event consumes it, the next read gets the one after
+			touch_event_pop();
+		} else {
+			i2c_pointer++;
+		}
+		return;
+	}
+
+	// Master writes
+	uint8_t data = TWI0.SDATA;
+
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+
+#if I2C_GENERAL_CALL_SYNC == 1
+	if (i2c_general_call) {
+		i2c_general_call_write(data);
+		return;
+	}
+#endif
+	if (i2c_pointer_pending) {
+		i2c_pointer         = data;
+		i2c_pointer_pending = false;
+		return;
+	}
+	// A local copy, the store through reg could alias it
+	uint8_t pointer = i2c_pointer;
+
+	if (pointer < I2C_REG_RW_END) {
+		volatile uint8_t *reg = i2c_register(pointer);
+
+		// Effects are looked up by mode, so a bad one is never stored
+		if (reg && (pointer != I2C_REG_MODE || data <= MODE_LAST)) {
+			*reg = data;
+		}
+	}
+	switch (pointer) {
+	case I2C_REG_CEILING:
+		// Never fully dark, as with the slider
+		if (data < CEILING_MIN) {
+			LED_CEILING = CEILING_MIN;
+		}
+		break;
+	case I2C_REG_FB_COMMIT:
+		framebuffer_commit();
+		break;
+#if VM_ENABLE == 1
+	case I2C_REG_PROG_DATA:
+		vm_load(data);
+		// vm_load_addr steps instead, so a page goes in one burst
+		return;
+	case I2C_REG_PROG_CTRL:
+		mailbox_post(CMD_PROG_CTRL, data, 0);
+		break;
+#endif
+	case I2C_REG_CMD:
+		mailbox_post(data, mailbox_arg[0], mailbox_arg[1]);
+		break;
+	case I2C_REG_BOOT:
+		if (data == I2C_BOOT_MAGIC) {
+			_PROTECTED_WRITE(RSTCTRL.SWRR, RSTCTRL_SWRE_bm);
+		}
+		break;
+	}
+	i2c_pointer = pointer + 1;
+}
+
+/*============================================================================
+void i2c_registers_init(void)
+------------------------------------------------------------------------------
+Purpose: Bring up TWI0 as the slave serving the register map
+Input  : none
+Output : none
+Notes  : The pins, bus speed and interrupt priority are set here, as
+         system_init() is generated by Atmel START. Before
+         i2c_publish_init(), which shares TWI0.
+============================================================================*/
+void i2c_registers_init(void)
+{
+	// TWI0 on its alternate pins, SDA on PA1 and SCL on PA2, which go to the
+	// SAO header. The default pins are PB1 and PB0.
+	PORTMUX.CTRLB |= PORTMUX_TWI0_bm;
+#if I2C_FAST_MODE_PLUS == 1
+	TWI0.CTRLA = TWI_FMPEN_bm | TWI_SDAHOLD_50NS_gc | TWI_SDASETUP_4CYC_gc;
+#endif
+	I2C_0_init();
+	// Level 1, so the slave preempts the PWM and touch ISRs
+	CPUINT.LVL1VEC = TWI0_TWIS_vect_num;
+	I2C_0_open();
+}
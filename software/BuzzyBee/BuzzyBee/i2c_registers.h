@@ -0,0 +1,94 @@
+/* BuzzyBee I2C register map
+ *
+ * A write transaction's first byte sets the register pointer, any further
+ * bytes are written from there on. Reads start at the register pointer. The
+ * pointer auto-increments after every byte, except on I2C_REG_EVENT so a burst
+ * read there drains the event queue, and on I2C_REG_PROG_DATA so a burst
+ * write there loads a run of program bytes. Registers that do not exist read
+ * back 0xFF and ignore writes.
+ *
+ * Writable registers live from 0x00, read-only status from I2C_REG_RO_BASE.
+ *
+ * With I2C_GENERAL_CALL_SYNC a general call write of I2C_GC_SYNC time_l time_h
+ * sets the millisecond clock to time and restarts the PWM period and the
+ * animation, on every board on the bus at the same SCL edge.
+ */
+#ifndef I2C_REGISTERS_H
+#define I2C_REGISTERS_H
+
+#include <stdint.h>
+
+#define I2C_ID 0xBB
+#define I2C_VERSION 16
+
+// Written to I2C_REG_BOOT to reset into the bootloader, see software/BuzzyBoot
+#define I2C_BOOT_MAGIC 0xB7
+
+// General call command byte for a sync broadcast
+#define I2C_GC_SYNC 0xB5
+
+// Read/write registers
+enum {
+	I2C_REG_MODE,     // Run mode, see RUNMODE, others are ignored
+	I2C_REG_LED0,     // LED_RIGHT level, perceptual, see lut.h
+	I2C_REG_LED1,     // LED_LEFT level
+	I2C_REG_CEILING,  // Brightness ceiling, writes below CEILING_MIN set CEILING_MIN
+	I2C_REG_FB_LED0,  // Stream frame, see framebuffer.h
+	I2C_REG_FB_LED1,
+	I2C_REG_FB_VIBE,
+	I2C_REG_FB_COMMIT, // Any write shows the frame at the next PWM period
+	I2C_REG_PROG_ADDR, // Program upload with VM_ENABLE, see vm.h
+	I2C_REG_PROG_DATA,
+	I2C_REG_PROG_CTRL,  // Posted to the command mailbox
+	I2C_REG_BOOT,      // Write I2C_BOOT_MAGIC to start the bootloader
+	I2C_REG_CMD_ARG0,  // Command arguments, see mailbox.h
+	I2C_REG_CMD_ARG1,
+	I2C_REG_CMD,       // Writing an opcode queues the command
+	I2C_REG_RW_END
+};
+
+#define I2C_REG_RO_BASE 0x80
+
+// Read-only registers
+enum {
+	I2C_REG_ID = I2C_REG_RO_BASE, // Always I2C_ID
+	I2C_REG_VERSION,              // Register map version
+	I2C_REG_KEY0_STATE,           // QTouch state of the middle key, bit 7 set in detect
+	I2C_REG_KEY1_STATE,           // QTouch state of the butt key, bit 7 set in detect
+	I2C_REG_KEY0_COUNT,           // Touches on the middle key
+	I2C_REG_KEY1_COUNT,           // Touches on the butt key
+	I2C_REG_KEY0_HEALTH,          // SENSOR_HEALTH_x flags of the middle key, see touch.h
+	I2C_REG_KEY1_HEALTH,          // SENSOR_HEALTH_x flags of the butt key
+	I2C_REG_KEY0_FAULTS,          // Recalibrations of the middle key
+	I2C_REG_KEY1_FAULTS,          // Recalibrations of the butt key
+	I2C_REG_TICKS_L,              // Millisecond clock, low byte first
+	I2C_REG_TICKS_H,
+	I2C_REG_TRANSACTIONS,         // Transactions addressed to us, wraps
+	I2C_REG_FB_FPS_L,             // Stream frames shown in the last second
+	I2C_REG_FB_FPS_H,
+	I2C_REG_FB_DROPPED,           // Stream frames replaced before being shown
+	I2C_REG_PROG_STATE,           // VM_STOPPED, VM_RUNNING or VM_FAULT, with VM_ENABLE
+	I2C_REG_PROG_PC,              // Program counter
+	I2C_REG_NVM_STATUS,           // NVMCTRL.STATUS
+	I2C_REG_EVENT,                // Oldest touch event, removed by reading, see touch_events.h
+	I2C_REG_EVENT_COUNT,          // Touch events queued
+	I2C_REG_EVENT_OVERFLOW,       // Touch events dropped on a full queue
+	I2C_REG_SYNC_COUNT,           // General call syncs received, wraps
+	I2C_REG_ERRORS,               // Transactions dropped on a collision or bus error, wraps
+	I2C_REG_CMD_STATUS,           // CMD_STATUS_x of the last command run
+	I2C_REG_CMD_DONE,             // Commands run, wraps
+	I2C_REG_CMD_PENDING,          // Commands queued
+	I2C_REG_PUBLISH_SENT,         // Touch events published as master, wraps, see i2c_publish.h
+	I2C_REG_PUBLISH_LOST,         // Arbitrations lost while publishing, wraps
+	I2C_REG_PUBLISH_DROPPED,      // Touch events not published, wraps
+	I2C_REG_RENDER_TIME_L,        // Longest render in 0.1 us, see render.h
+	I2C_REG_RENDER_TIME_H,
+	I2C_REG_RENDER_OVERRUNS,      // Renders that missed their PWM period, wraps
+	I2C_REG_RENDER_BLEND_L,       // Longest render blending two modes, in 0.1 us
+	I2C_REG_RENDER_BLEND_H,
+	I2C_REG_RO_END
+};
+
+void i2c_registers_init(void);
+
+#endif // I2C_REGISTERS_H
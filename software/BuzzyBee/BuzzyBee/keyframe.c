@@ -0,0 +1,227 @@
+/* BuzzyBee keyframe animation engine, see keyframe.h */
+
+#include <atmel_start.h>
+#include <avr/pgmspace.h>
+
+#include "buzzybee.h"
+#include "keyframe.h"
+#include "lut.h"
+#include "prng.h"
+
+// Both LEDs glow, now and then one of them flares up
+static const keyframe_t kf_twinkle[] PROGMEM = {
+	{KF_LEDS, LED_GLOW, 0, KF_EASE_STEP},
+	{KF_RANDOM_TIME, 0, 120, KF_EASE_STEP},
+	{KF_LEDS | KF_PICK, 255, 40, KF_EASE_SINE | KF_IN_OUT},
+	{KF_PICKED, LED_GLOW, 40, KF_EASE_SINE | KF_IN_OUT},
+	KF_END
+};
+
+// LEDs take turns
+static const keyframe_t kf_bounce[] PROGMEM = {
+	{KF_LED_RIGHT, LED_GLOW, 0, KF_EASE_STEP},
+	{KF_LED_LEFT, 194, 8, KF_EASE_STEP},
+	{KF_LED_RIGHT, 194, 0, KF_EASE_STEP},
+	{KF_LED_LEFT, LED_GLOW, 8, KF_EASE_STEP},
+	KF_END
+};
+
+// Random levels
+static const keyframe_t kf_random[] PROGMEM = {
+	{KF_LED_RIGHT | KF_RANDOM, 194, 0, KF_EASE_STEP},
+	{KF_LED_LEFT | KF_RANDOM, 194, 16, KF_EASE_STEP},
+	KF_END
+};
+
+// Indexed by run mode
+static const keyframe_t *const kf_effects[] PROGMEM = {
+	[MODE_TWINKLE] = kf_twinkle,
+	[MODE_BOUNCE]  = kf_bounce,
+	[MODE_RANDOM]  = kf_random,
+};
+
+static void kf_set(keyframe_player_t *p, uint8_t mask, uint8_t level)
+{
+	if (mask & KF_LED_RIGHT) {
+		p->out[0] = level;
+	}
+	if (mask & KF_LED_LEFT) {
+		p->out[1] = level;
+	}
+}
+
+static uint8_t kf_curve(uint8_t easing, uint8_t t)
+{
+	switch (easing & KF_EASE_CURVE) {
+	case KF_EASE_QUAD:
+		return (uint16_t)t * t >> 8;
+	case KF_EASE_SINE:
+		return lut_ease(LUT_EASE_SINE, t);
+	case KF_EASE_EXPO:
+		return lut_ease(LUT_EASE_EXPO, t);
+	default:
+		return t;
+	}
+}
+
+/*============================================================================
+static uint8_t kf_ease(uint8_t easing, uint8_t t)
+------------------------------------------------------------------------------
+Purpose: Apply a keyframe's easing
+Input  : easing: KF_EASE_x, with KF_OUT or KF_IN_OUT
+         t: progress, 0 to 255
+Output : eased progress, 0 to 255
+Notes  : Out runs the curve backwards from the end, in-out runs it in over
+         the first half and out over the second
+============================================================================*/
+static uint8_t kf_ease(uint8_t easing, uint8_t t)
+{
+	if (easing & KF_IN_OUT) {
+		if (t < 128) {
+			return kf_curve(easing, t << 1) >> 1;
+		}
+		return 255 - (kf_curve(easing, (255 - t) << 1) >> 1);
+	}
+	if (easing & KF_OUT) {
+		return 255 - kf_curve(easing, 255 - t);
+	}
+	return kf_curve(easing, t);
+}
+
+/*============================================================================
+static void kf_load(keyframe_player_t *p)
+------------------------------------------------------------------------------
+Purpose: Start the next keyframe of the effect
+Input  : p: player
+Output : none
+Notes  : Random choices are made here, once per keyframe. A step keyframe
+         sets its level straight away and only waits out its duration.
+============================================================================*/
+static void kf_load(keyframe_player_t *p)
+{
+	keyframe_t frame;
+
+	memcpy_P(&frame, p->next++, sizeof(frame));
+	if (frame.channel == 0 && frame.duration == 0) {
+		// KF_END, loop the effect
+		p->next = p->effect;
+	}
+
+	p->mask = frame.channel & KF_LEDS;
+	if (frame.channel & KF_PICK) {
+		p->picked = (p->mask == KF_LEDS) ? 1 << (prng_next() >> 15) : p->mask;
+	}
+	if (frame.channel & (KF_PICK | KF_PICKED)) {
+		p->mask = p->picked;
+	}
+	p->level = frame.level;
+	if (frame.channel & KF_RANDOM) {
+		p->level = prng_range(p->level + 1);
+	}
+	p->duration = frame.duration;
+	if (frame.channel & KF_RANDOM_TIME) {
+		p->duration = prng_range(p->duration + 1);
+	}
+	p->easing  = frame.easing;
+	p->elapsed = 0;
+	p->from[0] = p->out[0];
+	p->from[1] = p->out[1];
+
+	if (p->easing == KF_EASE_STEP || p->duration == 0) {
+		kf_set(p, p->mask, p->level);
+		p->mask = 0;
+	}
+}
+
+/*============================================================================
+static void kf_tick(keyframe_player_t *p, uint8_t ticks)
+------------------------------------------------------------------------------
+Purpose: Advance the effect by a number of ticks and render where it is now
+Input  : p: player
+         ticks: ticks since the last call
+Output : none
+Notes  : Keyframes that ended in between are finished without rendering
+         their intermediate levels. At most KF_MAX_STEPS keyframes are
+         started per call, a backlog beyond them is dropped.
+============================================================================*/
+static void kf_tick(keyframe_player_t *p, uint8_t ticks)
+{
+	uint16_t elapsed = p->elapsed + ticks;
+
+	for (uint8_t step = 0; elapsed >= p->duration; step++) {
+		kf_set(p, p->mask, p->level);
+		if (step == KF_MAX_STEPS) {
+			// Start the next keyframe on the next tick
+			p->mask     = 0;
+			p->duration = 0;
+			elapsed     = 0;
+			break;
+		}
+		elapsed -= p->duration;
+		kf_load(p);
+	}
+	p->elapsed = elapsed;
+
+	if (p->mask) {
+		uint8_t e = kf_ease(p->easing, ((uint16_t)p->elapsed << 8) / p->duration);
+		for (uint8_t channel = 0; channel < 2; channel++) {
+			if (p->mask & (1 << channel)) {
+				uint8_t from = p->from[channel];
+				if (p->level >= from) {
+					p->out[channel] = from + ((uint16_t)(p->level - from) * e >> 8);
+				} else {
+					p->out[channel] = from - ((uint16_t)(from - p->level) * e >> 8);
+				}
+			}
+		}
+	}
+}
+
+/*============================================================================
+void keyframe_start(keyframe_player_t *player, uint8_t effect)
+------------------------------------------------------------------------------
+Purpose: Run an effect from its first keyframe
+Input  : player: player to run it on
+         effect: run mode, MODE_TWINKLE to MODE_RANDOM
+Output : none
+Notes  : Called from the main loop. The effect starts from LED_GLOW.
+============================================================================*/
+void keyframe_start(keyframe_player_t *player, uint8_t effect)
+{
+	player->effect   = (const keyframe_t *)pgm_read_ptr(&kf_effects[effect]);
+	player->next     = player->effect;
+	player->mask     = 0;
+	player->duration = 0;
+	player->elapsed  = 0;
+	player->out[0]   = LED_GLOW;
+	player->out[1]   = LED_GLOW;
+
+	cpu_irq_disable();
+	player->last = timeTicks;
+	cpu_irq_enable();
+}
+
+/*============================================================================
+void keyframe_update(keyframe_player_t *player)
+------------------------------------------------------------------------------
+Purpose: Bring the effect up to the millisecond clock
+Input  : player: player to update
+Output : none
+Notes  : Called from the main loop, as often as it gets round to it. All
+         ticks since the last call are run at once, so the effect keeps its
+         speed however long the loop takes.
+============================================================================*/
+void keyframe_update(keyframe_player_t *player)
+{
+	uint16_t now, ticks;
+
+	cpu_irq_disable();
+	now = timeTicks;
+	cpu_irq_enable();
+
+	ticks = (uint16_t)(now - player->last) / KF_TICK_MS;
+	if (ticks) {
+		player->last += ticks * KF_TICK_MS;
+		kf_tick(player, (ticks > 255) ? 255 : ticks);
+	}
+}
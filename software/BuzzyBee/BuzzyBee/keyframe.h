@@ -0,0 +1,82 @@
+/* BuzzyBee keyframe animation engine
+ *
+ * The built-in effects are tables of keyframes in flash. Each keyframe moves
+ * its channels from wherever they are to a target level over a duration,
+ * along an easing curve, then the next keyframe starts. The table is looped
+ * until the effect changes. A new effect only costs its table in flash; the
+ * RAM is one keyframe_player_t per effect running at the same time, which
+ * renders into its own levels rather than LED_PWM, see compositor.h.
+ *
+ * Durations are in ticks of KF_TICK_MS on the millisecond clock. An update
+ * runs every tick that has passed since the last one and shows only the
+ * result, so a slow main loop skips frames instead of slowing the effect down.
+ * Levels are interpolated in 8 bit fixed point, and at most KF_MAX_STEPS
+ * keyframes start per update, so an update costs a bounded number of cycles.
+ *
+ * Channels are the VM's LED bits: bit 0 LED_RIGHT, bit 1 LED_LEFT. Flags in
+ * the channel byte make a keyframe vary each time it runs:
+ *
+ *   KF_PICK        use one of the channels, picked at random
+ *   KF_PICKED      use the channel picked last
+ *   KF_RANDOM      random level from 0 to level
+ *   KF_RANDOM_TIME random duration from 0 to duration
+ *
+ * A keyframe without channels only waits, one with no channels and no
+ * duration, KF_END, ends the table.
+ */
+#ifndef KEYFRAME_H
+#define KEYFRAME_H
+
+#include <stdint.h>
+
+#define KF_TICK_MS 10
+#define KF_MAX_STEPS 4
+
+// Channel bits
+#define KF_LED_RIGHT 0x01
+#define KF_LED_LEFT 0x02
+#define KF_LEDS 0x03
+#define KF_PICK 0x10
+#define KF_PICKED 0x20
+#define KF_RANDOM 0x40
+#define KF_RANDOM_TIME 0x80
+
+// Easing: a curve, run as it is (in), mirrored (KF_OUT) or both (KF_IN_OUT)
+enum {
+	KF_EASE_STEP, // Jump to the level, then hold it
+	KF_EASE_LINEAR,
+	KF_EASE_QUAD,
+	KF_EASE_SINE, // From lut.h
+	KF_EASE_EXPO  // From lut.h
+};
+#define KF_EASE_CURVE 0x0F
+#define KF_OUT 0x40    // Fast start, slow finish
+#define KF_IN_OUT 0x80 // Slow start and finish
+
+typedef struct {
+	uint8_t channel;  // Channel bits and flags
+	uint8_t level;    // Target level
+	uint8_t duration; // In ticks
+	uint8_t easing;   // KF_EASE_x, with KF_OUT or KF_IN_OUT
+} keyframe_t;
+
+#define KF_END {0, 0, 0, KF_EASE_STEP}
+
+typedef struct {
+	const keyframe_t *effect;
+	const keyframe_t *next;
+	uint8_t           mask;
+	uint8_t           level;
+	uint8_t           duration;
+	uint8_t           elapsed;
+	uint8_t           easing;
+	uint8_t           picked;
+	uint8_t           from[2];
+	uint8_t           out[2]; // Rendered LED levels
+	uint16_t          last;
+} keyframe_player_t;
+
+void keyframe_start(keyframe_player_t *player, uint8_t effect);
+void keyframe_update(keyframe_player_t *player);
+
+#endif // KEYFRAME_H
@@ -0,0 +1,67 @@
+/* BuzzyBee lookup tables, see lut.h
+ *
+ * LUT_256(f) expands to f(0), f(1) ... f(255). Each f() is a floating point
+ * constant expression of its index, folded by the compiler into a byte, so
+ * the curves are written out as maths instead of as numbers to keep in step.
+ */
+
+#include "lut.h"
+
+#define LUT_4(f, i) f(i), f(i + 1), f(i + 2), f(i + 3)
+#define LUT_16(f, i) LUT_4(f, i), LUT_4(f, i + 4), LUT_4(f, i + 8), LUT_4(f, i + 12)
+#define LUT_64(f, i) LUT_16(f, i), LUT_16(f, i + 16), LUT_16(f, i + 32), LUT_16(f, i + 48)
+#define LUT_256(f) LUT_64(f, 0), LUT_64(f, 64), LUT_64(f, 128), LUT_64(f, 192)
+
+#define LUT_BYTE(v) ((uint8_t)(255.0 * (v) + 0.5))
+#define LUT_X(i) ((i) / 255.0)
+
+// CIE 1931: lightness L* from 0 to 100 to relative luminance
+#define LUT_CIE(l) (((l) > 8.0) ? (((l) + 16.0) / 116.0) * (((l) + 16.0) / 116.0) * (((l) + 16.0) / 116.0) : (l) / 903.3)
+#define LUT_GAMMA(i) LUT_BYTE(LUT_CIE(100.0 * LUT_X(i)))
+
+// Easing curves at the knots x = i / 32
+#define LUT_33(f) LUT_16(f, 0), LUT_16(f, 16), f(32)
+#define LUT_K(i) ((i) / 32.0)
+
+// 1 - cos(pi / 2 x), cos from its Taylor series in u = a^2
+#define LUT_COS_U(u) (1.0 - (u) / 2 * (1.0 - (u) / 12 * (1.0 - (u) / 30 * (1.0 - (u) / 56 * (1.0 - (u) / 90)))))
+#define LUT_SINE_A(a) (1.0 - LUT_COS_U((a) * (a)))
+#define LUT_SINE(i) LUT_BYTE(LUT_SINE_A(1.5707963 * LUT_K(i)))
+
+// 2^(10 x - 10) = (e^(z / 16))^16, z = (10 x - 10) ln 2, e^ from its Taylor series
+#define LUT_EXP_Z(z) (1.0 + (z) * (1.0 + (z) / 2 * (1.0 + (z) / 3 * (1.0 + (z) / 4 * (1.0 + (z) / 5 * (1.0 + (z) / 6))))))
+#define LUT_SQ(v) ((v) * (v))
+#define LUT_EXP16(e) LUT_SQ(LUT_SQ(LUT_SQ(LUT_SQ(e))))
+#define LUT_EXPO(i) ((i) ? LUT_BYTE(LUT_EXP16(LUT_EXP_Z((10.0 * LUT_K(i) - 10.0) * 0.6931472 / 16))) : 0)
+
+const uint8_t lut_gamma_table[256] PROGMEM = {LUT_256(LUT_GAMMA)};
+
+const uint8_t lut_ease_table[LUT_EASE_COUNT][LUT_EASE_KNOTS] PROGMEM = {
+	[LUT_EASE_SINE] = {LUT_33(LUT_SINE)},
+	[LUT_EASE_EXPO] = {LUT_33(LUT_EXPO)},
+};
+
+/*============================================================================
+uint8_t lut_ease(uint8_t curve, uint8_t t)
+------------------------------------------------------------------------------
+Purpose: Look up an easing curve
+Input  : curve: LUT_EASE_x
+         t: progress, 0 to 255
+Output : eased progress, 0 to 255
+Notes  : Interpolates linearly between the knots, which are close enough
+         that no point is more than one level off the full curve
+============================================================================*/
+uint8_t lut_ease(uint8_t curve, uint8_t t)
+{
+	// Spread t over the knots' 0 to 256, so 255 lands on the last one
+	uint16_t       u    = t + (t >> 7);
+	const uint8_t *knot = &lut_ease_table[curve][u >> 3];
+	uint8_t        v    = pgm_read_byte(knot);
+	uint8_t        f    = u & 7;
+
+	if (f) {
+		// The curves only rise, so the step to the next knot is positive
+		v += ((uint16_t)(uint8_t)(pgm_read_byte(knot + 1) - v) * f) >> 3;
+	}
+	return v;
+}
@@ -0,0 +1,49 @@
+/* BuzzyBee lookup tables
+ *
+ * LED levels are perceptual: equal steps in level look like equal steps in
+ * brightness. lut_gamma() maps a level to a PWM duty cycle along the CIE 1931
+ * lightness curve, and the PWM ISR applies it to every LED, whatever set the
+ * level.
+ *
+ * The easing curves run from 0 to 255 over t = 0 to 255 and are the "in"
+ * half: slow start, fast finish. Mirror them for "out". They are kept at 33
+ * knots each and interpolated by lut_ease(), as full tables would take half
+ * a kB of the flash.
+ *
+ * All tables are computed by the compiler from constant expressions, see
+ * lut.c, so nothing runs pow() or floating point on the device.
+ */
+#ifndef LUT_H
+#define LUT_H
+
+#include <avr/pgmspace.h>
+#include <stdint.h>
+
+// Easing curves
+enum {
+	LUT_EASE_SINE, // 1 - cos(pi / 2 t)
+	LUT_EASE_EXPO, // 2^(10 t - 10)
+	LUT_EASE_COUNT
+};
+
+#define LUT_EASE_KNOTS 33
+
+extern const uint8_t lut_gamma_table[256] PROGMEM;
+extern const uint8_t lut_ease_table[LUT_EASE_COUNT][LUT_EASE_KNOTS] PROGMEM;
+
+uint8_t lut_ease(uint8_t curve, uint8_t t);
+
+/*============================================================================
+static inline uint8_t lut_gamma(uint8_t level)
+------------------------------------------------------------------------------
+Purpose: Map a perceptual level to a PWM duty cycle
+Input  : level: 0 to 255
+Output : duty cycle, 0 to 255
+Notes  :
+============================================================================*/
+static inline uint8_t lut_gamma(uint8_t level)
+{
+	return pgm_read_byte(&lut_gamma_table[level]);
+}
+
+#endif // LUT_H
@@ -0,0 +1,67 @@
+/* BuzzyBee I2C command mailbox, see mailbox.h */
+
+#include <atmel_start.h>
+
+#include "haptic.h"
+#include "mailbox.h"
+#include "settings.h"
+#include "vm.h"
+
+volatile uint8_t mailbox_arg[2];
+volatile uint8_t mailbox_status;
+volatile uint8_t mailbox_done;
+volatile uint8_t mailbox_pending;
+
+uint8_t mailbox_op[MAILBOX_SIZE];
+uint8_t mailbox_args[MAILBOX_SIZE][2];
+uint8_t mailbox_head;
+
+/*============================================================================
+void mailbox_run(void)
+------------------------------------------------------------------------------
+Purpose: Run every queued command
+Input  : none
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void mailbox_run(void)
+{
+	while (mailbox_pending) {
+		uint8_t *arg = mailbox_args[mailbox_head];
+		uint8_t  status = CMD_STATUS_OK;
+
+		switch (mailbox_op[mailbox_head]) {
+		case CMD_NOP:
+			break;
+		case CMD_SAVE:
+			settings_save();
+			break;
+		case CMD_RECALIBRATE:
+			for (uint8_t key = 0; key < DEF_NUM_SENSORS; key++) {
+				if (arg[0] & (1 << key)) {
+					calibrate_node(key);
+				}
+			}
+			break;
+#if VM_ENABLE == 1
+		case CMD_PROG_CTRL:
+			vm_control(arg[0]);
+			break;
+#endif
+		case CMD_HAPTIC:
+			haptic_play(arg[0]);
+			break;
+		default:
+			status = CMD_STATUS_BAD_OPCODE;
+			break;
+		}
+
+		// With mailbox_pending, as mailbox_post() finds the free slot from both
+		cpu_irq_disable();
+		mailbox_head   = (mailbox_head + 1) & (MAILBOX_SIZE - 1);
+		mailbox_status = status;
+		mailbox_done++;
+		mailbox_pending--;
+		cpu_irq_enable();
+	}
+}
@@ -0,0 +1,74 @@
+/* BuzzyBee I2C command mailbox
+ *
+ * Work too slow for the I2C ISR is posted here instead: the ISR queues the
+ * command and acknowledges straight away, and the main loop runs everything
+ * queued in one batch. The host writes the arguments and then the opcode, in
+ * one burst from I2C_REG_CMD_ARG0, and polls I2C_REG_CMD_PENDING or
+ * I2C_REG_CMD_DONE before reading the result from I2C_REG_CMD_STATUS.
+ */
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <stdint.h>
+
+// Must be a power of 2
+#define MAILBOX_SIZE 4
+
+// Opcodes
+enum {
+	CMD_NOP,
+	CMD_SAVE,        // Save mode and brightness ceiling to EEPROM
+	CMD_RECALIBRATE, // Recalibrate the keys in arg0, bit 0 middle, bit 1 butt
+	CMD_PROG_CTRL,   // VM_CTRL_x bits in arg0, posted by I2C_REG_PROG_CTRL
+	CMD_HAPTIC,      // Play the HAPTIC_x pattern in arg0, see haptic.h
+	CMD_COUNT
+};
+
+// Completion codes
+enum {
+	CMD_STATUS_OK,
+	CMD_STATUS_BAD_OPCODE,
+	CMD_STATUS_FULL // A command arrived with the mailbox full and was dropped
+};
+
+// Staging for the arguments written over I2C
+extern volatile uint8_t mailbox_arg[2];
+// Result of the last command run
+extern volatile uint8_t mailbox_status;
+// Commands run, wraps
+extern volatile uint8_t mailbox_done;
+extern volatile uint8_t mailbox_pending;
+
+// Queue, oldest command at mailbox_head
+extern uint8_t mailbox_op[MAILBOX_SIZE];
+extern uint8_t mailbox_args[MAILBOX_SIZE][2];
+extern uint8_t mailbox_head;
+
+void mailbox_run(void);
+
+/*============================================================================
+static inline void mailbox_post(uint8_t op, uint8_t arg0, uint8_t arg1)
+------------------------------------------------------------------------------
+Purpose: Queue a command
+Input  : op: CMD_x opcode
+         arg0, arg1: arguments
+Output : none
+Notes  : Called from the I2C ISR, never blocks
+============================================================================*/
+static inline __attribute__((always_inline)) void mailbox_post(uint8_t op, uint8_t arg0, uint8_t arg1)
+{
+	// Read once, the main loop only takes it down with interrupts off
+	uint8_t pending = mailbox_pending;
+
+	if (pending == MAILBOX_SIZE) {
+		mailbox_status = CMD_STATUS_FULL;
+		return;
+	}
+	uint8_t slot          = (mailbox_head + pending) & (MAILBOX_SIZE - 1);
+	mailbox_op[slot]      = op;
+	mailbox_args[slot][0] = arg0;
+	mailbox_args[slot][1] = arg1;
+	mailbox_pending       = pending + 1;
+}
+
+#endif // MAILBOX_H
@@ -3,197 +3,200 @@
 
 #include <atmel_start.h>
 #include <util/delay.h>
+#include <buzzybee_config.h>
+
+#include "buzzybee.h"
+#include "compositor.h"
+#include "entropy.h"
+#include "framebuffer.h"
+#include "haptic.h"
+#include "i2c_publish.h"
+#include "i2c_registers.h"
+#include "mailbox.h"
+#include "prng.h"
+#include "render.h"
+#include "settings.h"
+#include "touch_events.h"
+#include "vm.h"
 
 extern volatile uint8_t measurement_done_touch;
-extern volatile uint8_t LED_PWM[2];
-extern volatile uint16_t timeTicks;
 
-// Logarithmic brightness levels
-const uint8_t pwm_log[] = {30,43,59,78,102,137,196,255};
-	
-typedef enum {
-	MODE_TWINKLE,
-	MODE_BOUNCE,
-	MODE_RANDOM
-} RUNMODE;
+volatile RUNMODE run_mode = MODE_TWINKLE;
+volatile uint8_t touch_count[2];
+volatile bool animation_synced;
+volatile uint16_t animation_sync_time;
 
 int main(void){
 	
 	uint8_t key_status = 0;
 	
 	system_init();
+	entropy_init();
 	touch_init();
-	
-	cpu_irq_enable(); /* Global Interrupt Enable */
-	
-	LED_LEFT_set_level(true);
-	_delay_ms(200);
-	LED_RIGHT_set_level(true);
-	
-	VIBE_set_level(true);
-	_delay_ms(50);
-	VIBE_set_level(false);
-	_delay_ms(50);
-	VIBE_set_level(true);
-	_delay_ms(50);
-	VIBE_set_level(false);	
-	_delay_ms(50);
-	VIBE_set_level(true);
-	_delay_ms(50);
-	VIBE_set_level(false);
-	_delay_ms(50);
+	touch_event_init();
+	i2c_registers_init();
+#if I2C_PUBLISH_ENABLE == 1
+	i2c_publish_init();
+#endif
+	settings_load();
 	
 	TIMER_0_init();
+	haptic_init();
 	
-	LED_PWM[0] = 14;
-	LED_PWM[1] = 14;
-	
-	uint8_t brightnessPosition = 0;
-	uint8_t twinkleLED = 0;
-	bool directionUp = true;
-	bool twinkling = false;
-	uint8_t randomLED = 0;
+	cpu_irq_enable(); /* Global Interrupt Enable */
 	
-	uint8_t counter = 0;
+	LED_PWM[1] = 255;
+	_delay_ms(200);
+	LED_PWM[0] = 255;
 	
-	RUNMODE mode = MODE_TWINKLE;
+	// Buzz while the LEDs fade down into the saved mode
+	haptic_play(HAPTIC_PULSES);
+	RUNMODE mode = run_mode;
+	compositor_start(mode, true);
+	uint8_t key_touched = 0;
 	
 	bool touched = false;
 	bool buzzed = false;
+	bool dragged = false;
+	bool seeded = false;
 	
 
 	/* Replace with your application code */
 	while (1) {
 		
+		// Read once, the I2C ISR can write it at any time
+		RUNMODE next = run_mode;
+		if(next != mode || animation_synced){
+			// Mode written over I2C, or a sync broadcast restarting the animation
+			bool synced = animation_synced;
+			if(synced){
+				// Same random sequence on every synced board
+				prng_seed(animation_sync_time);
+				animation_synced = false;
+				seeded = true;
+			}
+			if(next > MODE_LAST){
+				next = MODE_TWINKLE;
+				run_mode = next;
+			}
+			mode = next;
+			haptic_set(0);
+			// Synced boards restart in step, anything else crossfades
+			compositor_start(mode, !synced);
+		}
+		
+		// Effects render once per RENDER_DIVIDER PWM periods
+		if(render_begin()){
+			compositor_render();
+			render_end();
+		}
 		
-		if(!touched && !buzzed){
-			
-			if(mode == MODE_TWINKLE){
-				if(!twinkling){
-					// Not twinkling, wait a random time before starting a twinkle
-					if((rand() % 500) == 0){
-						// Time to twinkle
-						twinkling = true;
-						// Pick a new LED
-						twinkleLED = rand() % 2;
-					}
-				}
-				
-				if(((timeTicks % 50) < 2) && twinkling){
-					if(directionUp){
-						// Go up in brightness
-						LED_PWM[twinkleLED] = pwm_log[brightnessPosition++];
-						if(brightnessPosition == 8){
-							directionUp = false;
-						}
-					}
-					else{
-						// Go down in brightness
-						LED_PWM[twinkleLED] = pwm_log[--brightnessPosition];
-						if(brightnessPosition == 0){
-							directionUp = true;
-							twinkling = false;
-							LED_PWM[0] = 14;
-							LED_PWM[1] = 14;
-						}
-					}
-				}
+		touch_process();
+		if (measurement_done_touch == 1) {
+			if(!seeded){
+				// PTC noise, unless a sync has seeded the boards alike
+				entropy_add_touch();
+				seeded = true;
 			}
-			
-			if(mode == MODE_BOUNCE){
-				if(counter == 75){
-					counter = 0;
-					if(randomLED == 0){
-						LED_PWM[0] = 14;
-						LED_PWM[1] = 128;
-						randomLED = 1;
-					}
-					else{
-						LED_PWM[0] = 128;
-						LED_PWM[1] = 14;
-						randomLED = 0;
-					}
-					
-				}
-				else{
-					counter++;
-				}
+#if DEF_SLIDER_ENABLE == 1
+			// Dragging across both pads sets the brightness ceiling instead of changing mode
+			if(get_scroller_state(0) & SCROLLER_DRAG){
+				uint8_t ceiling = get_scroller_position(0);
+				LED_CEILING = (ceiling < CEILING_MIN) ? CEILING_MIN : ceiling;
+				dragged = true;
 			}
+#endif
 			
-			if(mode == MODE_RANDOM){
-				if(counter == 150){
-					counter = 0;
-					
-					LED_PWM[0] = rand() % 128;
-					LED_PWM[1] = rand() % 128;
+			// Count and queue touches on both keys for the I2C host
+			for(uint8_t i = 0; i < 2; i++){
+				if(get_sensor_state(i) & KEY_TOUCHED_MASK){
+					if(!(key_touched & (1 << i))){
+						touch_count[i]++;
+						touch_event_push(TOUCH_EVENT_PRESS | i);
+#if I2C_PUBLISH_ENABLE == 1
+						i2c_publish(TOUCH_EVENT_PRESS | i);
+#endif
+					}
+					key_touched |= (1 << i);
 				}
 				else{
-					counter++;
+					if(key_touched & (1 << i)){
+						touch_event_push(i);
+#if I2C_PUBLISH_ENABLE == 1
+						i2c_publish(i);
+#endif
+					}
+					key_touched &= ~(1 << i);
 				}
-				
 			}
 			
-		}
-		else if(!buzzed){
-			
-			// Mode is about to change, light up all the LEDs
-			for(uint8_t i = 0; i < 2; i++){
-				LED_PWM[i] = 184;
-			}
-			
-		}		
-		
-		touch_process();
-		if (measurement_done_touch == 1) {
 			key_status = get_sensor_state(0) & KEY_TOUCHED_MASK;
 			if (0u != key_status) {
 				touched = true;
+				if(dragged){
+					// Setting the ceiling, no mode change to show
+					compositor_release(LAYER_TOUCH);
+				} else if(mode != MODE_STREAM){
+					// Mode is about to change, light up all the LEDs
+					compositor_layer(LAYER_TOUCH, LAYER_LEDS, 225, BLEND_REPLACE, 255);
+				}
 				_delay_ms(5);
 			} else {
-				if(touched){
+				// The host owns the LEDs while streaming, touches are only reported
+				if(touched && !dragged && mode != MODE_STREAM){
+					// The new mode starts at the top of the loop
 					switch(mode){
 						case MODE_TWINKLE:
-							// Move to bounce mode
-							twinkleLED = 0;
-							directionUp = true;
-							mode = MODE_BOUNCE;
+							run_mode = MODE_BOUNCE;
 							break;
 						case MODE_BOUNCE:
-							// Move to off mode
-							mode = MODE_RANDOM;
+							run_mode = MODE_RANDOM;
 							break;
 						case MODE_RANDOM:
-							// Move to twinkle mode
-							LED_PWM[0] = 14;
-							LED_PWM[1] = 14;
-							twinkleLED = 0;
-							directionUp = true;
-							brightnessPosition = 0;
-							mode = MODE_TWINKLE;
+							// On to the uploaded program, if there is one
+							run_mode = vm_loaded() ? MODE_PROGRAM : MODE_TWINKLE;
+							break;
+						case MODE_PROGRAM:
+							run_mode = MODE_TWINKLE;
+							break;
+						case MODE_STREAM:
+							// Left only over I2C
 							break;
 					}
-
-					touched = false;
 				}
+				if(touched){
+					compositor_release(LAYER_TOUCH);
+				}
+				touched = false;
 			}
 			
-			// Vibrate
+			// Vibrate, unless the touch is a drag across both pads
 			key_status = get_sensor_state(1) & KEY_TOUCHED_MASK;
-			if (0u != key_status) {
-				VIBE_set_level(true);
-				LED_PWM[0] = 255;
-				LED_PWM[1] = 255;
+			if (0u != key_status && !dragged) {
+				haptic_set(255);
+				compositor_layer(LAYER_ALERT, LAYER_LEDS, 255, BLEND_MAX, 255);
 				buzzed = true;
 			} else {
 				if(buzzed){
-					VIBE_set_level(false);
-					LED_PWM[0] = 14;
-					LED_PWM[1] = 14;
+					haptic_set(0);
+					compositor_release(LAYER_ALERT);
 					buzzed = false;
 				}
-			}			
+			}
+			
+#if DEF_SLIDER_ENABLE == 1
+			if(!(get_scroller_state(0) & SCROLLER_TOUCH_DETECT)){
+				dragged = false;
+			}
+#endif
 		}	
 		
+		framebuffer_update();
+		mailbox_run();
+#if I2C_PUBLISH_ENABLE == 1
+		i2c_publish_update();
+#endif
+		
 		_delay_ms(1);	
 		
 	}
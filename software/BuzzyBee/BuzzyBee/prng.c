@@ -0,0 +1,18 @@
+/* BuzzyBee pseudo random numbers, see prng.h */
+
+#include "prng.h"
+
+uint16_t prng_state = 0xACE1;
+
+/*============================================================================
+void prng_seed(uint16_t seed)
+------------------------------------------------------------------------------
+Purpose: Restart the sequence
+Input  : seed: any value, 0 is replaced as it would stop the generator
+Output : none
+Notes  : The same seed gives the same sequence, so synced boards agree
+============================================================================*/
+void prng_seed(uint16_t seed)
+{
+	prng_state = seed ? seed : 0xACE1;
+}
@@ -0,0 +1,75 @@
+/* BuzzyBee pseudo random numbers
+ *
+ * A 16 bit xorshift generator, shifts 7, 9, 8, with a period of 65535. The
+ * shifts by 8 and 9 are byte moves on the AVR. Counted from the clang
+ * listing, prng_next() inline is 36 cycles, loads and stores included.
+ * prng_range() with a constant n adds 9 and a call to __mulhi3, whose
+ * shift and add loop runs once per bit of the random byte: 17 to 105
+ * cycles, so 62 to 150 in all, simulated over every state with libgcc's
+ * routine.
+ *
+ * libc's rand() and % were not counted, so these are estimates: rand() is
+ * a 32 bit divide and two 32 bit multiplies, with no hardware multiplier
+ * about 1200 cycles, and each % on top is a 16 bit divide of about 220
+ * more.
+ *
+ * prng_range() scales by multiplying instead of dividing, and prng_chance()
+ * turns "1 in n" into a compare, with the division folded by the compiler
+ * when n is a constant.
+ */
+#ifndef PRNG_H
+#define PRNG_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+extern uint16_t prng_state;
+
+void prng_seed(uint16_t seed);
+
+/*============================================================================
+static inline uint16_t prng_next(void)
+------------------------------------------------------------------------------
+Purpose: Next number
+Input  : none
+Output : 1 to 65535
+Notes  : Not for ISRs, the state is not protected
+============================================================================*/
+static inline uint16_t prng_next(void)
+{
+	uint16_t x = prng_state;
+
+	x ^= x << 7;
+	x ^= x >> 9;
+	x ^= x << 8;
+	prng_state = x;
+	return x;
+}
+
+/*============================================================================
+static inline uint8_t prng_range(uint16_t n)
+------------------------------------------------------------------------------
+Purpose: Random number below n
+Input  : n: 1 to 256
+Output : 0 to n - 1
+Notes  : Takes the top byte, which is the best mixed
+============================================================================*/
+static inline uint8_t prng_range(uint16_t n)
+{
+	return ((prng_next() >> 8) * n) >> 8;
+}
+
+/*============================================================================
+static inline bool prng_chance(uint16_t n)
+------------------------------------------------------------------------------
+Purpose: Bernoulli trial, true 1 time in n
+Input  : n: 1 to 65535, best a constant
+Output : true with a chance of 1 / n
+Notes  :
+============================================================================*/
+static inline bool prng_chance(uint16_t n)
+{
+	return prng_next() <= (uint16_t)(65535U / n);
+}
+
+#endif // PRNG_H
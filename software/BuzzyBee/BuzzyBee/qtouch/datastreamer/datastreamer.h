@@ -0,0 +1,49 @@
+/*============================================================================
+Filename : datastreamer.h
+Project : BuzzyBee
+Purpose : Binary touch data streamer over USART0 TXD (PB2, test pad J18)
+
+Frame layout, little endian, one frame per touch post-processing cycle:
+    0xA5                      sync
+    uint8_t  sequence         increments per frame, also for dropped frames
+    uint8_t  node count N
+    N x {
+        uint16_t signal
+        uint16_t reference
+        int16_t  delta        signal - reference
+        uint16_t comp cap     raw node_comp_caps
+        uint8_t  state        key sensor_state
+    }
+    uint8_t  checksum         XOR of every byte after the sync byte
+
+software/tools/datastreamer_plot.py decodes and plots the stream.
+============================================================================*/
+
+#ifndef DATASTREAMER_H
+#define DATASTREAMER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif // __cplusplus
+
+/* Baud rate of the streamer output */
+#define DATASTREAMER_BAUD 115200UL
+
+/* Transmit ring buffer size in bytes, power of two */
+#define DATASTREAMER_BUFFER_SIZE 64u
+
+#define DATASTREAMER_SYNC 0xA5u
+
+/* Frames dropped because the transmit buffer was full (saturating) */
+extern uint8_t datastreamer_dropped;
+
+void datastreamer_init(void);
+void datastreamer_output(void);
+
+#ifdef __cplusplus
+}
+#endif // __cplusplus
+
+#endif /* DATASTREAMER_H */
@@ -0,0 +1,118 @@
+/*============================================================================
+Filename : datastreamer_UART_tiny.c
+Project : BuzzyBee
+Purpose : Binary touch data streamer. Frames are queued into a ring buffer
+          and sent from the USART0 data register empty interrupt, so the
+          touch processing never waits for the UART. A frame that does not
+          fit is dropped whole.
+============================================================================*/
+
+#include "touch.h"
+
+#if DEF_TOUCH_DATA_STREAMER_ENABLE == 1
+
+#include <compiler.h>
+#include <clock_config.h>
+#include <port.h>
+#include "datastreamer.h"
+
+#define DATASTREAMER_BUFFER_MASK (DATASTREAMER_BUFFER_SIZE - 1u)
+#define DATASTREAMER_FRAME_SIZE (4u + (9u * DEF_NUM_SENSORS))
+
+static uint8_t          tx_buffer[DATASTREAMER_BUFFER_SIZE];
+static volatile uint8_t tx_head;
+static volatile uint8_t tx_tail;
+static uint8_t          tx_checksum;
+static uint8_t          sequence;
+
+uint8_t datastreamer_dropped;
+
+static void datastreamer_put(uint8_t data)
+{
+	tx_buffer[tx_head] = data;
+	tx_head            = (tx_head + 1u) & DATASTREAMER_BUFFER_MASK;
+	tx_checksum ^= data;
+}
+
+static void datastreamer_put16(uint16_t data)
+{
+	datastreamer_put((uint8_t)data);
+	datastreamer_put((uint8_t)(data >> 8));
+}
+
+/*============================================================================
+void datastreamer_init(void)
+------------------------------------------------------------------------------
+Purpose: Configures USART0 for transmit only on its default TXD pin (PB2)
+Input  : none
+Output : none
+Notes  : 8N1, DATASTREAMER_BAUD
+============================================================================*/
+void datastreamer_init(void)
+{
+	PORTB_set_pin_level(2, true);
+	PORTB_set_pin_dir(2, PORT_DIR_OUT);
+
+	USART0.BAUD  = (uint16_t)(((4UL * F_CPU) + (DATASTREAMER_BAUD / 2u)) / DATASTREAMER_BAUD);
+	USART0.CTRLC = USART_CMODE_ASYNCHRONOUS_gc | USART_PMODE_DISABLED_gc | USART_SBMODE_1BIT_gc | USART_CHSIZE_8BIT_gc;
+	USART0.CTRLB = USART_TXEN_bm;
+}
+
+/*============================================================================
+void datastreamer_output(void)
+------------------------------------------------------------------------------
+Purpose: Queues one frame with the signal, reference, delta, compensation
+         capacitance and state of every sensor
+Input  : none
+Output : none
+Notes  : Never blocks; drops the frame when the ring buffer lacks space
+============================================================================*/
+void datastreamer_output(void)
+{
+	uint16_t sensor;
+	uint16_t signal;
+	uint16_t reference;
+	uint8_t  space = (tx_tail - tx_head - 1u) & DATASTREAMER_BUFFER_MASK;
+
+	sequence++;
+	if (space < DATASTREAMER_FRAME_SIZE) {
+		if (datastreamer_dropped < 0xFFu) {
+			datastreamer_dropped++;
+		}
+		return;
+	}
+
+	datastreamer_put(DATASTREAMER_SYNC);
+	tx_checksum = 0u;
+	datastreamer_put(sequence);
+	datastreamer_put(DEF_NUM_SENSORS);
+
+	for (sensor = 0u; sensor < DEF_NUM_SENSORS; sensor++) {
+		signal    = get_sensor_node_signal(sensor);
+		reference = get_sensor_node_reference(sensor);
+		datastreamer_put16(signal);
+		datastreamer_put16(reference);
+		datastreamer_put16(signal - reference);
+		datastreamer_put16(get_sensor_cc_val(sensor));
+		datastreamer_put(get_sensor_state(sensor));
+	}
+
+	datastreamer_put(tx_checksum);
+
+	USART0.CTRLA |= USART_DREIE_bm;
+}
+
+ISR(USART0_DRE_vect)
+{
+	uint8_t tail = tx_tail;
+
+	USART0.TXDATAL = tx_buffer[tail];
+	tail           = (tail + 1u) & DATASTREAMER_BUFFER_MASK;
+	tx_tail        = tail;
+
+	if (tail == tx_head) {
+		USART0.CTRLA &= ~USART_DREIE_bm;
+	}
+}
+
+#endif /* DEF_TOUCH_DATA_STREAMER_ENABLE */
@@ -49,6 +49,10 @@ uint16_t get_sensor_cc_val(uint16_t sensor_node);
 void     update_sensor_cc_val(uint16_t sensor_node, uint16_t new_cc_value);
 uint8_t  get_sensor_state(uint16_t sensor_node);
 void     update_sensor_state(uint16_t sensor_node, uint8_t new_state);
+uint16_t get_sensor_noise(uint16_t sensor_node);
+uint8_t  get_sensor_filter_level(uint16_t sensor_node);
+uint8_t  get_sensor_health(uint16_t sensor_node);
+uint8_t  get_sensor_fault_count(uint16_t sensor_node);
 void     calibrate_node(uint16_t sensor_node);
 uint8_t  get_scroller_state(uint16_t sensor_node);
 uint16_t get_scroller_position(uint16_t sensor_node);
@@ -31,6 +31,10 @@ Copyright (c) 2019 Microchip. All rights reserved.
 
 #include "port.h"
 
+#if DEF_TOUCH_DATA_STREAMER_ENABLE == 1
+#include "datastreamer/datastreamer.h"
+#endif
+
 /*----------------------------------------------------------------------------
  *   prototypes
  *----------------------------------------------------------------------------*/
@@ -63,6 +67,28 @@ static void qtm_post_process_complete();
  */
 static void qtm_error_callback(uint8_t error);
 
+/*! \brief Node noise estimate and adaptive filter level post-processing module.
+ */
+static touch_ret_t touch_noise_process(qtm_acquisition_control_t *qtm_acq_control_ptr);
+
+#if DEF_SLIDER_ENABLE == 1
+/*! \brief Two-pad slider post-processing module.
+ */
+static touch_ret_t touch_slider_process(qtm_touch_key_control_t *qtm_lib_key_group_ptr);
+#endif
+
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+/*! \brief Sensor health monitor post-processing module.
+ */
+static touch_ret_t touch_health_process(qtm_acquisition_control_t *qtm_acq_control_ptr);
+#endif
+
+#if DEF_FREQ_HOP_GATE_ENABLE == 1
+/*! \brief Noise gate in front of the frequency hop auto tune module.
+ */
+static touch_ret_t touch_freq_hop_gate_process(qtm_freq_hop_autotune_control_t *qtm_freq_hop_autotune_control);
+#endif
+
 /*----------------------------------------------------------------------------
  *     Global Variables
  *----------------------------------------------------------------------------*/
@@ -120,6 +146,16 @@ qtm_freq_hop_autotune_data_t qtm_freq_hop_autotune_data1
 qtm_freq_hop_autotune_control_t qtm_freq_hop_autotune_control1
     = {&qtm_freq_hop_autotune_data1, &qtm_freq_hop_autotune_config1};
 
+#if DEF_FREQ_HOP_GATE_ENABLE == 1
+/* Gate state: hopping active, scans left to refill the median buffer, quiet scans seen */
+uint8_t freq_hop_gate_active;
+uint8_t freq_hop_gate_prime_count;
+uint8_t freq_hop_gate_quiet_count;
+#define FREQ_HOP_PROC (module_proc_t)&touch_freq_hop_gate_process
+#else
+#define FREQ_HOP_PROC (module_proc_t)&qtm_freq_hop_autotune
+#endif
+
 /**********************************************************/
 /*********************** Keys Module **********************/
 /**********************************************************/
@@ -147,6 +183,56 @@ qtm_touch_key_config_t qtlib_key_configs_set1[DEF_NUM_SENSORS] = {KEY_0_PARAMS,
 qtm_touch_key_control_t qtlib_key_set1
     = {&qtlib_key_grp_data_set1, &qtlib_key_grp_config_set1, &qtlib_key_data_set1[0], &qtlib_key_configs_set1[0]};
 
+/**********************************************************/
+/******************* Two-pad Slider Module ****************/
+/**********************************************************/
+
+#if DEF_SLIDER_ENABLE == 1
+/* Slider state, filtered position (Q8.6) and position at contact */
+uint8_t  slider_state;
+uint16_t slider_position;
+uint8_t  slider_contact_position;
+#define SLIDER_PROC (module_proc_t)&touch_slider_process,
+#define SLIDER_DM (void *)&qtlib_key_set1,
+#else
+#define SLIDER_PROC
+#define SLIDER_DM
+#endif
+
+/**********************************************************/
+/******************* Sensor Health Monitor ****************/
+/**********************************************************/
+
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+/* Current fault bits and recalibrations triggered per node */
+uint8_t sensor_health[DEF_NUM_CHANNELS];
+uint8_t sensor_fault_count[DEF_NUM_CHANNELS];
+
+/* Time in detect, holdoff after recalibration and attempts on the current fault */
+uint16_t sensor_detect_time[DEF_NUM_CHANNELS];
+uint8_t  sensor_recal_holdoff[DEF_NUM_CHANNELS];
+uint8_t  sensor_recal_retries[DEF_NUM_CHANNELS];
+#define HEALTH_PROC (module_proc_t)&touch_health_process,
+#define HEALTH_DM (void *)&qtlib_acq_set1,
+#else
+#define HEALTH_PROC
+#define HEALTH_DM
+#endif
+
+/**********************************************************/
+/*************** Noise / Adaptive Oversampling ************/
+/**********************************************************/
+
+/* Previous signal per median filter frequency, 0 for none yet, and filtered
+ * noise estimate (x16) per node */
+uint16_t node_noise_last_signal[DEF_NUM_CHANNELS][NUM_FREQ_STEPS];
+uint16_t node_noise_estimate[DEF_NUM_CHANNELS];
+
+#if DEF_ADAPTIVE_FILTER_ENABLE == 1
+/* Consecutive quiet measurements seen at the current filter level */
+uint8_t adaptive_filter_quiet_count[DEF_NUM_CHANNELS];
+#endif
+
 /**********************************************************/
 /****************  Binding Layer Module  ******************/
 /**********************************************************/
@@ -157,7 +243,8 @@ qtm_touch_key_control_t qtlib_key_set1
 
 #define LIB_MODULES_PROC_LIST                                                                                          \
 	{                                                                                                                  \
-		(module_proc_t) & qtm_freq_hop_autotune, (module_proc_t)&qtm_key_sensors_process, null                         \
+		(module_proc_t) & touch_noise_process, FREQ_HOP_PROC, (module_proc_t)&qtm_key_sensors_process,                 \
+		    SLIDER_PROC HEALTH_PROC null                                                                               \
 	}
 
 #define LIB_INIT_DATA_MODELS_LIST                                                                                      \
@@ -167,7 +254,8 @@ qtm_touch_key_control_t qtlib_key_set1
 
 #define LIB_DATA_MODELS_PROC_LIST                                                                                      \
 	{                                                                                                                  \
-		(void *)&qtm_freq_hop_autotune_control1, (void *)&qtlib_key_set1, null                                         \
+		(void *)&qtlib_acq_set1, (void *)&qtm_freq_hop_autotune_control1, (void *)&qtlib_key_set1, SLIDER_DM HEALTH_DM \
+		    null                                                                                                       \
 	}
 
 #define LIB_MODULES_ACQ_ENGINES_LIST                                                                                   \
@@ -328,6 +416,10 @@ static void qtm_post_process_complete(void)
 	} else {
 		measurement_done_touch = 1;
 	}
+
+#if DEF_TOUCH_DATA_STREAMER_ENABLE == 1
+	datastreamer_output();
+#endif
 }
 
 /*============================================================================
@@ -375,6 +467,310 @@ static void qtm_error_callback(uint8_t error)
 #endif
 }
 
+/*============================================================================
+static touch_ret_t touch_noise_process(qtm_acquisition_control_t *qtm_acq_control_ptr)
+------------------------------------------------------------------------------
+Purpose: Tracks the measurement noise of every node and, when enabled, selects
+         the lowest filter level that keeps the noise below a margin of the
+         key threshold.
+Input  : Pointer to acquisition set
+Output : TOUCH_SUCCESS
+Notes  : Noise is an IIR average of the absolute difference between successive
+         signals on the same frequency, which ignores slow drift. While
+         hopping, successive scans run on different frequencies, whose signals
+         differ by more than the noise, so each frequency keeps its own
+         previous signal. Nodes that are calibrating or in detect are not
+         sampled. The digital gain normalises the accumulated
+         signal, so the reference stays valid when the filter level changes.
+         One filter level step doubles the sample count and scales the noise
+         by about 1/sqrt(2); the estimate is rescaled on a step so that it
+         does not escalate again before new samples arrive.
+============================================================================*/
+static touch_ret_t touch_noise_process(qtm_acquisition_control_t *qtm_acq_control_ptr)
+{
+	uint16_t sensor_node;
+	uint16_t signal;
+	uint16_t last;
+	uint16_t diff;
+	uint8_t  step;
+
+	/* The frequency this scan ran on, still selected until the hop module runs */
+	for (step = 0u; step < NUM_FREQ_STEPS; step++) {
+		if (freq_hop_delay_selection[step] == qtm_acq_control_ptr->qtm_acq_node_group_config->freq_option_select) {
+			break;
+		}
+	}
+	if (step == NUM_FREQ_STEPS) {
+		/* Retuned away by the autotune, nothing to compare with */
+		return TOUCH_SUCCESS;
+	}
+
+	for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+		signal = qtm_acq_control_ptr->qtm_acq_node_data[sensor_node].node_acq_signals;
+		last   = node_noise_last_signal[sensor_node][step];
+		diff   = (signal > last) ? (signal - last) : (last - signal);
+		node_noise_last_signal[sensor_node][step] = signal;
+
+		/* First scan on this frequency */
+		if (last == 0u) {
+			continue;
+		}
+		if ((qtm_acq_control_ptr->qtm_acq_node_data[sensor_node].node_acq_status & NODE_CAL_MASK)
+		    || (qtlib_key_data_set1[sensor_node].sensor_state & KEY_TOUCHED_MASK)
+		    || (qtlib_key_data_set1[sensor_node].sensor_state == QTM_KEY_STATE_CAL)) {
+			continue;
+		}
+
+		/* Clamp so that the x16 difference fits the signed IIR step */
+		if (diff > 0x07FFu) {
+			diff = 0x07FFu;
+		}
+		node_noise_estimate[sensor_node]
+		    += (int16_t)((diff << 4) - node_noise_estimate[sensor_node]) >> DEF_ADAPTIVE_NOISE_FILTER;
+
+#if DEF_ADAPTIVE_FILTER_ENABLE == 1
+		{
+			qtm_acq_t81x_node_config_t *node_cfg = &qtm_acq_control_ptr->qtm_acq_node_config[sensor_node];
+			uint16_t                    limit
+			    = ((uint16_t)qtlib_key_configs_set1[sensor_node].channel_threshold << 4) >> DEF_ADAPTIVE_NOISE_MARGIN;
+
+			if (node_noise_estimate[sensor_node] > limit) {
+				adaptive_filter_quiet_count[sensor_node] = 0u;
+				if (node_cfg->node_oversampling < DEF_ADAPTIVE_FILTER_MAX) {
+					node_cfg->node_oversampling++;
+					node_noise_estimate[sensor_node] -= node_noise_estimate[sensor_node] >> 2;
+				}
+			} else if ((node_noise_estimate[sensor_node] << 1) < limit) {
+				if (++adaptive_filter_quiet_count[sensor_node] >= DEF_ADAPTIVE_STEP_DOWN_COUNT) {
+					adaptive_filter_quiet_count[sensor_node] = 0u;
+					if (node_cfg->node_oversampling > DEF_ADAPTIVE_FILTER_MIN) {
+						node_cfg->node_oversampling--;
+						node_noise_estimate[sensor_node] += node_noise_estimate[sensor_node] >> 1;
+					}
+				}
+			} else {
+				adaptive_filter_quiet_count[sensor_node] = 0u;
+			}
+		}
+#endif
+	}
+
+	return TOUCH_SUCCESS;
+}
+
+#if DEF_SLIDER_ENABLE == 1
+/*============================================================================
+static touch_ret_t touch_slider_process(qtm_touch_key_control_t *qtm_lib_key_group_ptr)
+------------------------------------------------------------------------------
+Purpose: Interpolates a 0-255 position between key 0 and key 1 from the node
+         deltas and low-pass filters it.
+Input  : Pointer to key group control data
+Output : TOUCH_SUCCESS
+Notes  : Position = 255 * delta1 / (delta0 + delta1). The deltas are scaled
+         down until the sum fits 8 bits so that a single 16-bit division is
+         needed per scan. A contact becomes a drag once the position has moved
+         DEF_SLIDER_DRAG_DEADBAND away from where it started.
+============================================================================*/
+static touch_ret_t touch_slider_process(qtm_touch_key_control_t *qtm_lib_key_group_ptr)
+{
+	qtm_touch_key_data_t *key_data = qtm_lib_key_group_ptr->qtm_touch_key_data;
+	uint16_t              delta[2];
+	uint16_t              sum;
+	uint8_t               position;
+	uint8_t               key;
+
+	for (key = 0u; key < 2u; key++) {
+		if ((key_data[key].sensor_state == QTM_KEY_STATE_DISABLE) || (key_data[key].sensor_state == QTM_KEY_STATE_INIT)
+		    || (key_data[key].sensor_state == QTM_KEY_STATE_CAL)
+		    || (key_data[key].sensor_state == QTM_KEY_STATE_CAL_ERR)) {
+			slider_state = 0u;
+			return TOUCH_SUCCESS;
+		}
+		delta[key] = 0u;
+		if (key_data[key].node_data_struct_ptr->node_acq_signals > key_data[key].channel_reference) {
+			delta[key] = key_data[key].node_data_struct_ptr->node_acq_signals - key_data[key].channel_reference;
+		}
+	}
+
+	sum = delta[0] + delta[1];
+	if (sum < DEF_SLIDER_CONTACT_THRESHOLD) {
+		slider_state = 0u;
+		return TOUCH_SUCCESS;
+	}
+
+	while (sum > 0xFFu) {
+		delta[1] >>= 1;
+		sum >>= 1;
+	}
+	position = (uint8_t)((delta[1] * 255u) / sum);
+
+	if (!(slider_state & SCROLLER_TOUCH_DETECT)) {
+		slider_state            = SCROLLER_TOUCH_DETECT;
+		slider_position         = (uint16_t)position << 6;
+		slider_contact_position = position;
+	} else {
+		slider_position += (int16_t)(((uint16_t)position << 6) - slider_position) >> DEF_SLIDER_FILTER;
+	}
+
+	position = (uint8_t)(slider_position >> 6);
+	if ((position > slider_contact_position + DEF_SLIDER_DRAG_DEADBAND)
+	    || (position + DEF_SLIDER_DRAG_DEADBAND < slider_contact_position)) {
+		slider_state |= SCROLLER_DRAG;
+	}
+
+	return TOUCH_SUCCESS;
+}
+#endif
+
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+/*============================================================================
+static touch_ret_t touch_health_process(qtm_acquisition_control_t *qtm_acq_control_ptr)
+------------------------------------------------------------------------------
+Purpose: Checks every node for calibration errors, a compensation capacitance
+         outside the expected range and keys stuck in detect, and recalibrates
+         only the affected node.
+Input  : Pointer to acquisition set
+Output : TOUCH_SUCCESS
+Notes  : node_comp_caps holds four nibbles of 0.00675 / 0.0675 / 0.675 /
+         6.75 pF; the finest one is ignored here. A node is recalibrated at
+         most DEF_HEALTH_RECAL_RETRIES times for one fault, DEF_HEALTH_RECAL_HOLDOFF
+         measurements apart. The fault bits stay set for diagnostics.
+============================================================================*/
+static touch_ret_t touch_health_process(qtm_acquisition_control_t *qtm_acq_control_ptr)
+{
+	uint16_t sensor_node;
+	uint16_t cc;
+	uint8_t  status;
+	uint8_t  health;
+
+	for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+		status = qtm_acq_control_ptr->qtm_acq_node_data[sensor_node].node_acq_status;
+		if (status & NODE_CAL_MASK) {
+			continue;
+		}
+
+		health = 0u;
+		if ((status & NODE_CAL_ERROR) || (qtlib_key_data_set1[sensor_node].sensor_state == QTM_KEY_STATE_CAL_ERR)) {
+			health |= SENSOR_HEALTH_CAL_ERROR;
+		}
+
+		cc = qtm_acq_control_ptr->qtm_acq_node_data[sensor_node].node_comp_caps;
+		cc = ((cc >> 4) & 0x0Fu) + (((cc >> 8) & 0x0Fu) * 10u) + (((cc >> 12) & 0x03u) * 100u);
+		if (cc >= DEF_HEALTH_CC_HIGH) {
+			health |= SENSOR_HEALTH_SHORTED;
+		} else if (cc < DEF_HEALTH_CC_LOW) {
+			health |= SENSOR_HEALTH_OPEN;
+		}
+
+		if (qtlib_key_data_set1[sensor_node].sensor_state & KEY_TOUCHED_MASK) {
+			if (sensor_detect_time[sensor_node] < DEF_HEALTH_STUCK_TIME) {
+				sensor_detect_time[sensor_node]++;
+			} else {
+				health |= SENSOR_HEALTH_STUCK;
+			}
+		} else {
+			sensor_detect_time[sensor_node] = 0u;
+		}
+
+		sensor_health[sensor_node] = health;
+
+		if (sensor_recal_holdoff[sensor_node]) {
+			sensor_recal_holdoff[sensor_node]--;
+		} else if (!health) {
+			sensor_recal_retries[sensor_node] = 0u;
+		} else if (sensor_recal_retries[sensor_node] < DEF_HEALTH_RECAL_RETRIES) {
+			sensor_recal_retries[sensor_node]++;
+			if (sensor_fault_count[sensor_node] < 0xFFu) {
+				sensor_fault_count[sensor_node]++;
+			}
+			sensor_recal_holdoff[sensor_node] = DEF_HEALTH_RECAL_HOLDOFF;
+			sensor_detect_time[sensor_node]   = 0u;
+			calibrate_node(sensor_node);
+		}
+	}
+
+	return TOUCH_SUCCESS;
+}
+#endif
+
+#if DEF_FREQ_HOP_GATE_ENABLE == 1
+/*============================================================================
+static touch_ret_t touch_freq_hop_gate_process(qtm_freq_hop_autotune_control_t *qtm_freq_hop_autotune_control)
+------------------------------------------------------------------------------
+Purpose: Runs the frequency hop auto tune module only while the measured noise
+         needs it. In clean conditions all scans stay on the first median
+         filter frequency and the median filter is skipped.
+Input  : Pointer to frequency hop container structure
+Output : touch_ret_t from the frequency hop module, or TOUCH_SUCCESS
+Notes  : Relies on touch_noise_process running first in the process list.
+         When hopping resumes, the median buffer holds stale samples, so the
+         raw signals are passed through until every frequency step has been
+         measured again.
+============================================================================*/
+static touch_ret_t touch_freq_hop_gate_process(qtm_freq_hop_autotune_control_t *qtm_freq_hop_autotune_control)
+{
+	uint16_t    sensor_node;
+	uint16_t    limit;
+	uint8_t     noisy = 0u;
+	uint8_t     quiet = 1u;
+	uint16_t    raw_signals[DEF_NUM_CHANNELS];
+	uint8_t     step;
+	touch_ret_t touch_ret;
+
+	for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+		limit = ((uint16_t)qtlib_key_configs_set1[sensor_node].channel_threshold << 4) >> DEF_FREQ_HOP_GATE_MARGIN;
+		if (node_noise_estimate[sensor_node] > limit) {
+			noisy = 1u;
+		}
+		if ((node_noise_estimate[sensor_node] << 1) >= limit) {
+			quiet = 0u;
+		}
+	}
+
+	if (noisy) {
+		freq_hop_gate_quiet_count = 0u;
+		if (!freq_hop_gate_active) {
+			freq_hop_gate_active      = 1u;
+			freq_hop_gate_prime_count = NUM_FREQ_STEPS;
+		}
+	} else if (freq_hop_gate_active && quiet) {
+		if (++freq_hop_gate_quiet_count >= DEF_FREQ_HOP_GATE_HOLD) {
+			freq_hop_gate_quiet_count = 0u;
+			freq_hop_gate_active      = 0u;
+			/* Back to a single frequency for the following scans */
+			*qtm_freq_hop_autotune_control->qtm_freq_hop_autotune_config->freq_option_select
+			    = qtm_freq_hop_autotune_control->qtm_freq_hop_autotune_config->median_filter_freq[0];
+			/* The other frequencies' signals will have drifted when hopping resumes */
+			for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+				for (step = 1u; step < NUM_FREQ_STEPS; step++) {
+					node_noise_last_signal[sensor_node][step] = 0u;
+				}
+			}
+		}
+	} else {
+		freq_hop_gate_quiet_count = 0u;
+	}
+
+	if (!freq_hop_gate_active) {
+		return TOUCH_SUCCESS;
+	}
+
+	if (freq_hop_gate_prime_count) {
+		freq_hop_gate_prime_count--;
+		for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+			raw_signals[sensor_node] = ptc_qtlib_node_stat1[sensor_node].node_acq_signals;
+		}
+		touch_ret = qtm_freq_hop_autotune(qtm_freq_hop_autotune_control);
+		for (sensor_node = 0u; sensor_node < DEF_NUM_CHANNELS; sensor_node++) {
+			ptc_qtlib_node_stat1[sensor_node].node_acq_signals = raw_signals[sensor_node];
+		}
+		return touch_ret;
+	}
+
+	return qtm_freq_hop_autotune(qtm_freq_hop_autotune_control);
+}
+#endif
+
 /*============================================================================
 void Timer_set_period(const uint8_t val)
 ------------------------------------------------------------------------------
@@ -415,6 +811,10 @@ void touch_init(void)
 
 	/* get a pointer to the binding layer control */
 	p_qtm_control = qmt_get_binding_layer_ptr();
+
+#if DEF_TOUCH_DATA_STREAMER_ENABLE == 1
+	datastreamer_init();
+#endif
 }
 
 /*============================================================================
@@ -528,6 +928,40 @@ void update_sensor_state(uint16_t sensor_node, uint8_t new_state)
 	qtlib_key_set1.qtm_touch_key_data[sensor_node].sensor_state = new_state;
 }
 
+uint16_t get_sensor_noise(uint16_t sensor_node)
+{
+	return (node_noise_estimate[sensor_node] >> 4);
+}
+
+uint8_t get_sensor_filter_level(uint16_t sensor_node)
+{
+	return (ptc_seq_node_cfg1[sensor_node].node_oversampling);
+}
+
+#if DEF_SLIDER_ENABLE == 1
+uint8_t get_scroller_state(uint16_t sensor_node)
+{
+	return (slider_state);
+}
+
+uint16_t get_scroller_position(uint16_t sensor_node)
+{
+	return (slider_position >> 6);
+}
+#endif
+
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+uint8_t get_sensor_health(uint16_t sensor_node)
+{
+	return (sensor_health[sensor_node]);
+}
+
+uint8_t get_sensor_fault_count(uint16_t sensor_node)
+{
+	return (sensor_fault_count[sensor_node]);
+}
+#endif
+
 void calibrate_node(uint16_t sensor_node)
 {
 	/* Calibrate Node */
@@ -201,6 +201,160 @@ extern "C" {
  */
 #define FREQ_AUTOTUNE_COUNT_IN 6
 
+/* Enable / Disable noise gating of the frequency hop module. When enabled,
+ * scans stay on a single frequency and the median filter is bypassed until
+ * the measured noise crosses the gate threshold.
+ * Range: 0 / 1
+ * Default value: 1
+ */
+#define DEF_FREQ_HOP_GATE_ENABLE 1
+
+/* Gate threshold below the touch threshold, as a right shift of the threshold.
+ * Hopping starts when noise on any node exceeds (threshold >> margin).
+ * Range: 0 to 4.
+ * Default value: 3 (12.5% of threshold)
+ */
+#define DEF_FREQ_HOP_GATE_MARGIN 3
+
+/* Number of consecutive quiet measurements (noise below half the gate
+ * threshold on all nodes) before hopping is switched off again.
+ * Range: 1 to 255.
+ * Default value: 250 (5 seconds at 20 ms measurement period)
+ */
+#define DEF_FREQ_HOP_GATE_HOLD 250
+
+/**********************************************************/
+/*************** Communication - Data Streamer ************/
+/**********************************************************/
+
+/* Enable / Disable the binary data streamer on USART0 TXD (PB2).
+ * See datastreamer/datastreamer.h for the frame layout. A tuning aid only:
+ * the application does not fit in the flash beside the bootloader with it
+ * on, so tune with another module turned off or without the bootloader.
+ * Range: 0u / 1u
+ * Default value: 0u
+ */
+#define DEF_TOUCH_DATA_STREAMER_ENABLE 0u
+
+/**********************************************************/
+/***************** Two-pad Slider Module ******************/
+/**********************************************************/
+
+/* Enable / Disable interpolation of a slider position between node 0
+ * (position 0) and node 1 (position 255).
+ * Range: 0 / 1
+ * Default value: 1
+ */
+#define DEF_SLIDER_ENABLE 1
+
+/* Minimum sum of both node deltas to report slider contact.
+ * Range: 1 to 255.
+ * Default value: 20
+ */
+#define DEF_SLIDER_CONTACT_THRESHOLD 20
+
+/* Position low-pass filter coefficient, as a right shift (IIR of 1 / 2^n).
+ * Range: 0 to 4.
+ * Default value: 2
+ */
+#define DEF_SLIDER_FILTER 2
+
+/* Position change from the contact point before the contact counts as a drag.
+ * Range: 1 to 255.
+ * Default value: 24
+ */
+#define DEF_SLIDER_DRAG_DEADBAND 24
+
+/* Slider state bits returned by get_scroller_state() */
+#define SCROLLER_TOUCH_DETECT 0x01u
+#define SCROLLER_DRAG 0x02u
+
+/**********************************************************/
+/*************** Sensor Health Monitor ********************/
+/**********************************************************/
+
+/* Enable / Disable detection of stuck, shorted and open sensors with
+ * selective recalibration of the affected node. Takes about 0.5 kB of flash
+ * and 16 bytes of RAM. Without it the I2C health registers read
+ * SENSOR_HEALTH_DISABLED and the fault registers 0.
+ * Range: 0 / 1
+ * Default value: 1
+ */
+#define DEF_HEALTH_MONITOR_ENABLE 1
+
+/* Compensation capacitance limits in units of 0.0675 pF. A node below the low
+ * limit is reported open, a node above the high limit is reported shorted.
+ * Range: 0 to 465.
+ * Default value: 30 (about 2 pF) / 440 (about 29.7 pF)
+ */
+#define DEF_HEALTH_CC_LOW 30
+#define DEF_HEALTH_CC_HIGH 440
+
+/* Continuous time in detect before a key is reported stuck. Acts as a backstop
+ * when DEF_MAX_ON_DURATION is 0 (disabled).
+ * Units: measurement periods
+ * Range: 1 to 65535.
+ * Default value: 1500 (30 seconds at 20 ms measurement period)
+ */
+#define DEF_HEALTH_STUCK_TIME 1500
+
+/* Measurements to wait after a recalibration before the node is checked again.
+ * Range: 1 to 255.
+ * Default value: 250 (5 seconds at 20 ms measurement period)
+ */
+#define DEF_HEALTH_RECAL_HOLDOFF 250
+
+/* Recalibration attempts on a persistent fault before the node is left alone.
+ * Range: 1 to 255.
+ * Default value: 3
+ */
+#define DEF_HEALTH_RECAL_RETRIES 3
+
+/* Fault bits returned by get_sensor_health() */
+#define SENSOR_HEALTH_CAL_ERROR 0x01u
+#define SENSOR_HEALTH_SHORTED 0x02u
+#define SENSOR_HEALTH_OPEN 0x04u
+#define SENSOR_HEALTH_STUCK 0x08u
+/* Read from the I2C health registers with the monitor built out */
+#define SENSOR_HEALTH_DISABLED 0x80u
+
+/**********************************************************/
+/************* Adaptive Oversampling Module ***************/
+/**********************************************************/
+
+/* Enable / Disable run-time selection of the node filter level from the
+ * measured signal noise. The filter level in NODE_x_PARAMS is used at boot.
+ * Range: 0 / 1
+ * Default value: 1
+ */
+#define DEF_ADAPTIVE_FILTER_ENABLE 1
+
+/* Lowest and highest filter level the adaptive selection may use.
+ * Range: FILTER_LEVEL_1 to FILTER_LEVEL_64
+ * Default value: FILTER_LEVEL_4 / FILTER_LEVEL_32
+ */
+#define DEF_ADAPTIVE_FILTER_MIN FILTER_LEVEL_4
+#define DEF_ADAPTIVE_FILTER_MAX FILTER_LEVEL_32
+
+/* Noise margin below the touch threshold, as a right shift of the threshold.
+ * The filter level is raised when noise exceeds (threshold >> margin).
+ * Range: 0 to 4.
+ * Default value: 2 (noise kept below 25% of threshold)
+ */
+#define DEF_ADAPTIVE_NOISE_MARGIN 2
+
+/* Noise estimate filter coefficient, as a right shift (IIR of 1 / 2^n).
+ * Range: 1 to 6.
+ * Default value: 3
+ */
+#define DEF_ADAPTIVE_NOISE_FILTER 3
+
+/* Number of consecutive quiet measurements before the filter level is lowered.
+ * Range: 1 to 255.
+ * Default value: 50 (1 second at 20 ms measurement period)
+ */
+#define DEF_ADAPTIVE_STEP_DOWN_COUNT 50
+
 #ifdef __cplusplus
 }
 #endif // __cplusplus
@@ -0,0 +1,59 @@
+/* BuzzyBee render stage, see render.h */
+
+#include <atmel_start.h>
+
+#include "render.h"
+
+volatile bool render_due;
+volatile bool render_busy;
+volatile uint8_t render_overruns;
+volatile uint16_t render_time;
+volatile uint16_t render_time_blend;
+bool render_blending;
+
+static uint16_t render_start;
+
+/*============================================================================
+bool render_begin(void)
+------------------------------------------------------------------------------
+Purpose: Start a render if one is due
+Input  : none
+Output : true if the caller should render now, and then call render_end()
+Notes  : Called from the main loop
+============================================================================*/
+bool render_begin(void)
+{
+	if (!render_due) {
+		return false;
+	}
+	render_busy  = true;
+	render_due   = false;
+	render_start = TCB0.CNT;
+	return true;
+}
+
+/*============================================================================
+void render_end(void)
+------------------------------------------------------------------------------
+Purpose: Publish the rendered levels to the next PWM period
+Input  : none
+Output : none
+Notes  : Times the render against TCB0, which counts CLK_PER / 2 and wraps
+         every millisecond
+============================================================================*/
+void render_end(void)
+{
+	uint16_t time = TCB0.CNT - render_start;
+
+	render_busy = false;
+	if ((int16_t)time < 0) {
+		time += TCB0.CCMP + 1;
+	}
+	if (render_blending) {
+		if (time > render_time_blend) {
+			render_time_blend = time;
+		}
+	} else if (time > render_time) {
+		render_time = time;
+	}
+}
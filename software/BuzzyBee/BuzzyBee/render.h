@@ -0,0 +1,42 @@
+/* BuzzyBee render stage
+ *
+ * Effects set the LED levels once every RENDER_DIVIDER PWM periods, about
+ * 100 Hz, when the PWM ISR flags render_due at the start of a period. The main
+ * loop brackets a render with render_begin() and render_end(). The PWM ISR
+ * does not latch new levels while a render runs, so no period shows half of
+ * one render and half of the previous one.
+ *
+ * render_overruns counts renders that missed their slot: started after the
+ * next one was already due, or still running at a period start. render_time
+ * is the longest render so far, against a budget of RENDER_DIVIDER periods.
+ * Renders that blend two effects, during a mode transition, are timed into
+ * render_time_blend instead, so the cost of a crossfade can be read against
+ * the steady state.
+ *
+ * Simulated on clang's AVR output, a crossfade render under both overlays
+ * takes at most about 4200 cycles, 5100 after a 300 ms stall, and a steady
+ * one 2800. The budget is RENDER_DIVIDER * 65536 = 196608 cycles, of which
+ * the PWM ISR, at about 90 cycles every 256, takes a third.
+ */
+#ifndef RENDER_H
+#define RENDER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+// PWM periods of about 3.3 ms per render
+#define RENDER_DIVIDER 3
+
+extern volatile bool render_due;
+extern volatile bool render_busy;
+extern volatile uint8_t render_overruns;
+// Longest render, in TCB0 counts of 0.1 us
+extern volatile uint16_t render_time;
+extern volatile uint16_t render_time_blend;
+// Set by the compositor for a render that blends two effects
+extern bool render_blending;
+
+bool render_begin(void);
+void render_end(void);
+
+#endif // RENDER_H
@@ -0,0 +1,53 @@
+/* BuzzyBee settings, see settings.h */
+
+#include <atmel_start.h>
+#include <avr/eeprom.h>
+#include <ccp.h>
+
+#include "buzzybee.h"
+#include "settings.h"
+#include "vm.h"
+
+#define SETTINGS_BYTE(offset) ((uint8_t *)(SETTINGS_EEPROM + (offset)))
+
+/*============================================================================
+void settings_load(void)
+------------------------------------------------------------------------------
+Purpose: Restore the saved mode and brightness ceiling
+Input  : none
+Output : none
+Notes  : Erased EEPROM reads 0xFF, which keeps the defaults, as does anything
+         out of range
+============================================================================*/
+void settings_load(void)
+{
+	uint8_t mode    = eeprom_read_byte(SETTINGS_BYTE(SETTINGS_MODE));
+	uint8_t ceiling = eeprom_read_byte(SETTINGS_BYTE(SETTINGS_CEILING));
+
+	// Streaming needs a host, and a program may have been erased since
+	if (mode <= MODE_RANDOM || (mode == MODE_PROGRAM && vm_loaded())) {
+		run_mode = mode;
+	}
+	if (ceiling >= CEILING_MIN) {
+		LED_CEILING = ceiling;
+	}
+}
+
+/*============================================================================
+void settings_save(void)
+------------------------------------------------------------------------------
+Purpose: Save the mode and brightness ceiling
+Input  : none
+Output : none
+Notes  : Run from the command mailbox. Program bytes loaded into the NVM page
+         buffer but not yet written are discarded, the host has to load them
+         again.
+============================================================================*/
+void settings_save(void)
+{
+	while (NVMCTRL.STATUS & NVMCTRL_EEBUSY_bm)
+		;
+	ccp_write_spm((void *)&NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEBUFCLR_gc);
+	eeprom_update_byte(SETTINGS_BYTE(SETTINGS_MODE), run_mode);
+	eeprom_update_byte(SETTINGS_BYTE(SETTINGS_CEILING), LED_CEILING);
+}
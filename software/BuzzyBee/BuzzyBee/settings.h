@@ -0,0 +1,16 @@
+/* BuzzyBee settings, kept in the last EEPROM page after the VM program */
+#ifndef SETTINGS_H
+#define SETTINGS_H
+
+#define SETTINGS_EEPROM (EEPROM_SIZE - EEPROM_PAGE_SIZE)
+
+// Offsets from SETTINGS_EEPROM
+enum {
+	SETTINGS_MODE,
+	SETTINGS_CEILING
+};
+
+void settings_load(void);
+void settings_save(void);
+
+#endif // SETTINGS_H
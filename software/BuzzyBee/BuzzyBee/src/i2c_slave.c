@@ -0,0 +1,198 @@
+/**
+ * \file
+ *
+ * \brief I2C slave driver.
+ *
+ */
+
+/**
+ * \addtogroup doc_driver_i2c_slave
+ *
+ * \section doc_driver_i2c_slave_rev Revision History
+ * - v0.0.0.1 Initial Commit
+ *
+ *@{
+ */
+#include <i2c_slave.h>
+#include <driver_init.h>
+#include <buzzybee_config.h>
+
+static void I2C_0_default_handler(void)
+{
+}
+
+static I2C_0_callback *I2C_0_read_interrupt_handler      = I2C_0_default_handler;
+static I2C_0_callback *I2C_0_write_interrupt_handler     = I2C_0_default_handler;
+static I2C_0_callback *I2C_0_address_interrupt_handler   = I2C_0_default_handler;
+static I2C_0_callback *I2C_0_stop_interrupt_handler      = I2C_0_default_handler;
+static I2C_0_callback *I2C_0_collision_interrupt_handler = I2C_0_default_handler;
+static I2C_0_callback *I2C_0_bus_error_interrupt_handler = I2C_0_default_handler;
+
+/* RXACK still holds the previous transaction's last ACK bit until the master
+ * has acknowledged the first byte, so the first read byte is always sent */
+static volatile bool I2C_0_first_read;
+
+/**
+ * \brief Initialize I2C slave interface
+ */
+void I2C_0_init()
+{
+
+	// TWI0.CTRLA = 0 << TWI_FMPEN_bp /* FM Plus Enable: disabled */
+	//		 | TWI_SDAHOLD_OFF_gc /* SDA hold time off */
+	//		 | TWI_SDASETUP_4CYC_gc; /* SDA setup time is 4 clock cycles */
+
+	TWI0.SADDR = I2C_SLAVE_ADDRESS << 1    /* Slave Address */
+	             | I2C_GENERAL_CALL_SYNC; /* General Call Recognition Enable */
+
+	// TWI0.SADDRMASK = 0 << TWI_ADDRMASK_gp /* Address Mask: 0 */
+	//		 | 0 << TWI_ADDREN_bp; /* Address Mask Enable: disabled */
+
+	TWI0.SCTRLA = TWI_DIEN_bm    /* Data Interrupt Enable: enabled */
+	              | TWI_APIEN_bm /* Address/Stop Interrupt Enable: enabled */
+	              | TWI_PIEN_bm; /* Stop Interrupt Enable: enabled */
+}
+
+/**
+ * \brief Enable I2C slave interface
+ */
+void I2C_0_open(void)
+{
+	TWI0.SCTRLA |= TWI_ENABLE_bm;
+}
+
+/**
+ * \brief Disable I2C slave interface
+ */
+void I2C_0_close(void)
+{
+	TWI0.SCTRLA &= ~TWI_ENABLE_bm;
+}
+
+/**
+ * \brief Dispatch the pending slave event to its callback
+ *
+ * For polled use. The TWI0 slave interrupt itself is served by the register
+ * map in i2c_registers.c, without the callbacks.
+ */
+void I2C_0_isr(void)
+{
+	uint8_t status = TWI0.SSTATUS;
+
+	if (status & TWI_COLL_bm) {
+		I2C_0_collision_interrupt_handler();
+		return;
+	}
+
+	if (status & TWI_BUSERR_bm) {
+		I2C_0_bus_error_interrupt_handler();
+		return;
+	}
+
+	if ((status & TWI_APIF_bm) && (status & TWI_AP_bm)) {
+		I2C_0_first_read = true;
+		I2C_0_address_interrupt_handler();
+		return;
+	}
+
+	if (status & TWI_DIF_bm) {
+		if (status & TWI_DIR_bm) {
+			// Master wishes to read from slave
+			if (I2C_0_first_read || !(status & TWI_RXACK_bm)) {
+				I2C_0_first_read = false;
+				I2C_0_read_interrupt_handler();
+				TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+			} else {
+				// Master NACKed the last byte, transaction is over
+				I2C_0_goto_unaddressed();
+			}
+		} else {
+			// Master wishes to write to slave
+			I2C_0_write_interrupt_handler();
+		}
+		return;
+	}
+
+	if ((status & TWI_APIF_bm) && !(status & TWI_AP_bm)) {
+		I2C_0_stop_interrupt_handler();
+		TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+	}
+}
+
+/**
+ * \brief Read the byte received from the master
+ */
+uint8_t I2C_0_read(void)
+{
+	return TWI0.SDATA;
+}
+
+/**
+ * \brief Load the byte to send to the master
+ */
+void I2C_0_write(uint8_t data)
+{
+	TWI0.SDATA = data;
+}
+
+/**
+ * \brief Enable I2C slave interface
+ */
+void I2C_0_enable(void)
+{
+	TWI0.SCTRLA |= TWI_ENABLE_bm;
+}
+
+/**
+ * \brief ACK the address or received byte and wait for the next one
+ */
+void I2C_0_send_ack(void)
+{
+	TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+}
+
+/**
+ * \brief NACK the address or received byte and end the transaction
+ */
+void I2C_0_send_nack(void)
+{
+	TWI0.SCTRLB = TWI_ACKACT_NACK_gc | TWI_SCMD_COMPTRANS_gc;
+}
+
+/**
+ * \brief Release the bus and wait for the next start condition
+ */
+void I2C_0_goto_unaddressed(void)
+{
+	TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+}
+
+void I2C_0_set_read_callback(I2C_0_callback handler)
+{
+	I2C_0_read_interrupt_handler = handler;
+}
+
+void I2C_0_set_write_callback(I2C_0_callback handler)
+{
+	I2C_0_write_interrupt_handler = handler;
+}
+
+void I2C_0_set_address_callback(I2C_0_callback handler)
+{
+	I2C_0_address_interrupt_handler = handler;
+}
+
+void I2C_0_set_stop_callback(I2C_0_callback handler)
+{
+	I2C_0_stop_interrupt_handler = handler;
+}
+
+void I2C_0_set_collision_callback(I2C_0_callback handler)
+{
+	I2C_0_collision_interrupt_handler = handler;
+}
+
+void I2C_0_set_bus_error_callback(I2C_0_callback handler)
+{
+	I2C_0_bus_error_interrupt_handler = handler;
+}
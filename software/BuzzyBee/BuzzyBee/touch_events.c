@@ -0,0 +1,50 @@
+/* BuzzyBee touch event queue, see touch_events.h */
+
+#include <atmel_start.h>
+
+#include "touch_events.h"
+
+volatile uint8_t touch_event = TOUCH_EVENT_NONE;
+volatile uint8_t touch_event_count;
+volatile uint8_t touch_event_overflow;
+
+uint8_t touch_event_queue[TOUCH_EVENT_QUEUE_SIZE];
+uint8_t touch_event_tail;
+
+/*============================================================================
+void touch_event_init(void)
+------------------------------------------------------------------------------
+Purpose: Release the attention line
+Input  : none
+Output : none
+Notes  : The output level stays low, the line is pulled low by making the
+         pin an output
+============================================================================*/
+void touch_event_init(void)
+{
+	PORTA.OUTCLR = TOUCH_EVENT_ATTN_bm;
+	PORTA.DIRCLR = TOUCH_EVENT_ATTN_bm;
+}
+
+/*============================================================================
+void touch_event_push(uint8_t event)
+------------------------------------------------------------------------------
+Purpose: Queue an event and assert the attention line
+Input  : event: key number, with TOUCH_EVENT_PRESS for a press
+Output : none
+Notes  : Called from the main loop. A full queue drops the new event.
+============================================================================*/
+void touch_event_push(uint8_t event)
+{
+	cpu_irq_disable();
+	if (touch_event_count == TOUCH_EVENT_QUEUE_SIZE) {
+		touch_event_overflow++;
+	} else {
+		touch_event_queue[(touch_event_tail + touch_event_count) & (TOUCH_EVENT_QUEUE_SIZE - 1)] = event;
+		if (touch_event_count++ == 0) {
+			touch_event = event;
+			PORTA.DIRSET = TOUCH_EVENT_ATTN_bm;
+		}
+	}
+	cpu_irq_enable();
+}
@@ -0,0 +1,62 @@
+/* BuzzyBee touch event queue
+ *
+ * Key presses and releases are queued by the main loop and read by the I2C
+ * host from I2C_REG_EVENT, oldest first. Reading an event removes it. While
+ * the queue holds events the open-drain attention line ATTN (SAO GPIO2, PA3)
+ * is pulled low, so the host can sleep until something happens. The host
+ * provides the pull-up.
+ */
+#ifndef TOUCH_EVENTS_H
+#define TOUCH_EVENTS_H
+
+#include <avr/io.h>
+#include <stdint.h>
+
+// Must be a power of 2
+#define TOUCH_EVENT_QUEUE_SIZE 8
+
+#define TOUCH_EVENT_NONE 0xFF
+// Set for a press, clear for a release, the low bits are the key number
+#define TOUCH_EVENT_PRESS 0x80
+
+// ATTN on PORTA. Set up here rather than in the Atmel START project, which
+// would drop it on regeneration.
+#define TOUCH_EVENT_ATTN_bm PIN3_bm
+
+// Oldest event, TOUCH_EVENT_NONE when the queue is empty
+extern volatile uint8_t touch_event;
+extern volatile uint8_t touch_event_count;
+// Events dropped on a full queue, wraps
+extern volatile uint8_t touch_event_overflow;
+
+// Queue, oldest event at touch_event_tail
+extern uint8_t touch_event_queue[TOUCH_EVENT_QUEUE_SIZE];
+extern uint8_t touch_event_tail;
+
+void touch_event_init(void);
+void touch_event_push(uint8_t event);
+
+/*============================================================================
+static inline void touch_event_pop(void)
+------------------------------------------------------------------------------
+Purpose: Remove the oldest event, releasing the attention line once the
+         queue is empty
+Input  : none
+Output : none
+Notes  : Called from the I2C ISR after touch_event has been sent
+============================================================================*/
+static inline __attribute__((always_inline)) void touch_event_pop(void)
+{
+	if (touch_event_count == 0) {
+		return;
+	}
+	touch_event_tail = (touch_event_tail + 1) & (TOUCH_EVENT_QUEUE_SIZE - 1);
+	if (--touch_event_count) {
+		touch_event = touch_event_queue[touch_event_tail];
+	} else {
+		touch_event = TOUCH_EVENT_NONE;
+		PORTA.DIRCLR = TOUCH_EVENT_ATTN_bm;
+	}
+}
+
+#endif // TOUCH_EVENTS_H
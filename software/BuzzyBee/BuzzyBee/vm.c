@@ -0,0 +1,256 @@
+/* BuzzyBee light pattern interpreter, see vm.h */
+
+#include <atmel_start.h>
+#include <avr/eeprom.h>
+#include <ccp.h>
+
+#include "buzzybee.h"
+#include "haptic.h"
+#include "prng.h"
+#include "vm.h"
+
+#if VM_ENABLE == 1
+
+volatile uint8_t vm_state = VM_STOPPED;
+volatile uint8_t vm_pc;
+volatile uint8_t vm_load_addr;
+uint8_t vm_led[2];
+static volatile bool vm_restart;
+
+static uint8_t vm_wait;
+static uint8_t vm_fade_mask;
+static uint8_t vm_fade_target;
+static uint8_t vm_vibe;
+static uint8_t vm_sp;
+static uint8_t vm_loop_pc[VM_LOOP_DEPTH];
+static uint8_t vm_loop_count[VM_LOOP_DEPTH];
+static uint16_t vm_last;
+
+static uint8_t vm_fetch(void)
+{
+	if (vm_pc >= VM_SIZE) {
+		vm_state = VM_FAULT;
+		return VM_OP_END;
+	}
+	return eeprom_read_byte((const uint8_t *)(uint16_t)vm_pc++);
+}
+
+static uint8_t vm_level(uint8_t channel)
+{
+	return (channel < 2) ? vm_led[channel] : vm_vibe;
+}
+
+static void vm_set(uint8_t mask, uint8_t level)
+{
+	if (mask & 0x01) {
+		vm_led[0] = level;
+	}
+	if (mask & 0x02) {
+		vm_led[1] = level;
+	}
+	if (mask & 0x04) {
+		vm_vibe = level;
+		haptic_set(level);
+	}
+}
+
+/*============================================================================
+static void vm_step(void)
+------------------------------------------------------------------------------
+Purpose: Run one instruction
+Input  : none
+Output : none
+Notes  :
+============================================================================*/
+static void vm_step(void)
+{
+	uint8_t a, b;
+
+	switch (vm_fetch()) {
+	case VM_OP_END:
+		vm_pc = 0;
+		vm_sp = 0;
+		break;
+	case VM_OP_SET:
+		a = vm_fetch();
+		vm_set(a, vm_fetch());
+		break;
+	case VM_OP_FADE:
+		vm_fade_mask   = vm_fetch();
+		vm_fade_target = vm_fetch();
+		vm_wait        = vm_fetch();
+		if (vm_wait == 0) {
+			vm_set(vm_fade_mask, vm_fade_target);
+			vm_fade_mask = 0;
+		}
+		break;
+	case VM_OP_WAIT:
+		vm_wait = vm_fetch();
+		break;
+	case VM_OP_LOOP:
+		if (vm_sp == VM_LOOP_DEPTH) {
+			vm_state = VM_FAULT;
+			break;
+		}
+		vm_loop_count[vm_sp] = vm_fetch();
+		vm_loop_pc[vm_sp++]  = vm_pc;
+		break;
+	case VM_OP_NEXT:
+		if (vm_sp == 0) {
+			vm_state = VM_FAULT;
+			break;
+		}
+		if (--vm_loop_count[vm_sp - 1]) {
+			vm_pc = vm_loop_pc[vm_sp - 1];
+		} else {
+			vm_sp--;
+		}
+		break;
+	case VM_OP_RANDOM:
+		a = vm_fetch();
+		b = vm_fetch();
+		vm_set(a, prng_range(b + 1));
+		break;
+	case VM_OP_TOUCH:
+		a = vm_fetch();
+		b = vm_fetch();
+		if (get_sensor_state(a & 0x01) & KEY_TOUCHED_MASK) {
+			vm_pc = b;
+		}
+		break;
+	case VM_OP_JUMP:
+		vm_pc = vm_fetch();
+		break;
+	default:
+		vm_state = VM_FAULT;
+		break;
+	}
+}
+
+/*============================================================================
+static void vm_tick(uint8_t ticks)
+------------------------------------------------------------------------------
+Purpose: Advance the running fade or wait, then run instructions until one
+         waits, for a number of ticks
+Input  : ticks: ticks since the last call, at most VM_MAX_SKIP
+Output : none
+Notes  : A fade jumps straight to where it is after the ticks. At most
+         VM_MAX_STEPS instructions per tick.
+============================================================================*/
+static void vm_tick(uint8_t ticks)
+{
+	uint8_t n;
+
+	do {
+		if (vm_wait) {
+			n = (ticks < vm_wait) ? ticks : vm_wait;
+			if (vm_fade_mask) {
+				// Cover the remaining distance in equal steps over the remaining ticks
+				for (uint8_t channel = 0; channel < 3; channel++) {
+					if (vm_fade_mask & (1 << channel)) {
+						int16_t level = vm_level(channel);
+						vm_set(1 << channel, level + ((int16_t)vm_fade_target - level) * n / vm_wait);
+					}
+				}
+			}
+			ticks -= n;
+			vm_wait -= n;
+			if (vm_wait) {
+				return;
+			}
+			vm_fade_mask = 0;
+		} else {
+			ticks--;
+		}
+
+		for (uint8_t step = 0; step < VM_MAX_STEPS && vm_state == VM_RUNNING && vm_wait == 0; step++) {
+			vm_step();
+		}
+	} while (ticks);
+}
+
+/*============================================================================
+bool vm_loaded(void)
+------------------------------------------------------------------------------
+Purpose: Check for a program in EEPROM
+Input  : none
+Output : true if EEPROM holds a program
+Notes  : Erased EEPROM reads 0xFF, which is not an opcode
+============================================================================*/
+bool vm_loaded(void)
+{
+	return eeprom_read_byte((const uint8_t *)0) != 0xFF;
+}
+
+/*============================================================================
+void vm_start(void)
+------------------------------------------------------------------------------
+Purpose: Run the program from the start
+Input  : none
+Output : none
+Notes  : Called from the main loop
+============================================================================*/
+void vm_start(void)
+{
+	vm_pc        = 0;
+	vm_sp        = 0;
+	vm_wait      = 0;
+	vm_fade_mask = 0;
+	vm_vibe      = 0;
+	vm_led[0]    = LED_GLOW;
+	vm_led[1]    = LED_GLOW;
+	vm_restart   = false;
+	vm_state     = vm_loaded() ? VM_RUNNING : VM_FAULT;
+
+	cpu_irq_disable();
+	vm_last = timeTicks;
+	cpu_irq_enable();
+}
+
+/*============================================================================
+void vm_update(void)
+------------------------------------------------------------------------------
+Purpose: Bring the interpreter up to the millisecond clock
+Input  : none
+Output : none
+Notes  : Called from the main loop in MODE_PROGRAM. Runs all ticks since the
+         last call, up to VM_MAX_SKIP, the rest are dropped.
+============================================================================*/
+void vm_update(void)
+{
+	uint16_t now, ticks;
+
+	if (vm_restart) {
+		vm_start();
+	}
+
+	cpu_irq_disable();
+	now = timeTicks;
+	cpu_irq_enable();
+
+	ticks = (uint16_t)(now - vm_last) / VM_TICK_MS;
+	if (ticks) {
+		vm_last += ticks * VM_TICK_MS;
+		vm_tick((ticks > VM_MAX_SKIP) ? VM_MAX_SKIP : ticks);
+	}
+}
+
+/*============================================================================
+void vm_control(uint8_t ctrl)
+------------------------------------------------------------------------------
+Purpose: Write the loaded page to EEPROM and/or restart the program
+Input  : ctrl: VM_CTRL_x bits
+Output : none
+Notes  : Run from the command mailbox, the restart happens in vm_update()
+============================================================================*/
+void vm_control(uint8_t ctrl)
+{
+	if (ctrl & VM_CTRL_WRITE) {
+		ccp_write_spm((void *)&NVMCTRL.CTRLA, NVMCTRL_CMD_PAGEERASEWRITE_gc);
+	}
+	if (ctrl & VM_CTRL_RUN) {
+		vm_restart = true;
+	}
+}
+
+#endif
@@ -0,0 +1,113 @@
+/* BuzzyBee light pattern interpreter
+ *
+ * A program is a byte string stored in EEPROM from address 0 and run in
+ * MODE_PROGRAM. Every VM_TICK_MS the interpreter runs instructions until one
+ * waits, or VM_MAX_STEPS have run, so a tick costs a bounded number of cycles
+ * whatever the program does. Ticks follow the millisecond clock: ticks missed
+ * by a slow main loop are caught up on the next update, up to VM_MAX_SKIP.
+ *
+ * Channels are bit masks: bit 0 LED_RIGHT, bit 1 LED_LEFT, bit 2 the
+ * vibration motor, whose level is its intensity, see haptic.h. LED levels go to
+ * vm_led, which the compositor shows, and start at LED_GLOW. Times are in ticks and
+ * addresses are byte offsets into the program.
+ *
+ *   VM_OP_END                    restart from address 0
+ *   VM_OP_SET    mask level      set channels
+ *   VM_OP_FADE   mask level time fade channels linearly, waits until done
+ *   VM_OP_WAIT   time            wait
+ *   VM_OP_LOOP   count           run up to the matching VM_OP_NEXT count times,
+ *                                0 runs it 256 times
+ *   VM_OP_NEXT
+ *   VM_OP_RANDOM mask max        set channels to a random level 0..max
+ *   VM_OP_TOUCH  key addr        jump when key 0 (middle) or 1 (butt) is touched
+ *   VM_OP_JUMP   addr            jump
+ *
+ * Unknown opcodes, unbalanced loops and running off the end stop the program
+ * with VM_FAULT.
+ *
+ * Programs are uploaded over I2C one EEPROM page at a time: write the page
+ * offset to I2C_REG_PROG_ADDR, the page's bytes to I2C_REG_PROG_DATA, then
+ * VM_CTRL_WRITE to I2C_REG_PROG_CTRL, which goes through the command mailbox,
+ * and wait for the command to complete and NVMCTRL_EEBUSY_bm in
+ * I2C_REG_NVM_STATUS to clear before the next page. Uploading stops the
+ * program, VM_CTRL_RUN starts the new one.
+ *
+ * Built with VM_ENABLE only. Without it there is never a program to run.
+ */
+#ifndef VM_H
+#define VM_H
+
+#include <avr/io.h>
+#include <buzzybee_config.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#define VM_TICK_MS 10
+#define VM_MAX_STEPS 8
+#define VM_MAX_SKIP 16
+#define VM_LOOP_DEPTH 2
+// The last EEPROM page holds the settings
+#define VM_SIZE (EEPROM_SIZE - EEPROM_PAGE_SIZE)
+
+enum {
+	VM_OP_END,
+	VM_OP_SET,
+	VM_OP_FADE,
+	VM_OP_WAIT,
+	VM_OP_LOOP,
+	VM_OP_NEXT,
+	VM_OP_RANDOM,
+	VM_OP_TOUCH,
+	VM_OP_JUMP
+};
+
+// VM state
+enum {
+	VM_STOPPED, // Not started, or stopped by an upload
+	VM_RUNNING,
+	VM_FAULT
+};
+
+// I2C_REG_PROG_CTRL bits
+#define VM_CTRL_WRITE 0x01 // Write the loaded bytes to EEPROM
+#define VM_CTRL_RUN 0x02   // Restart the program
+
+#if VM_ENABLE == 1
+
+extern volatile uint8_t vm_state;
+extern volatile uint8_t vm_pc;
+extern volatile uint8_t vm_load_addr;
+extern uint8_t vm_led[2];
+
+bool vm_loaded(void);
+void vm_start(void);
+void vm_update(void);
+void vm_control(uint8_t ctrl);
+
+/*============================================================================
+static inline void vm_load(uint8_t data)
+------------------------------------------------------------------------------
+Purpose: Load a program byte into the EEPROM page buffer at vm_load_addr
+Input  : data: program byte
+Output : none
+Notes  : Called from the I2C ISR. Stops the running program.
+============================================================================*/
+static inline __attribute__((always_inline)) void vm_load(uint8_t data)
+{
+	if (vm_load_addr < VM_SIZE) {
+		vm_state = VM_STOPPED;
+		*(volatile uint8_t *)(EEPROM_START + vm_load_addr) = data;
+	}
+	vm_load_addr++;
+}
+
+#else
+
+static inline bool vm_loaded(void)
+{
+	return false;
+}
+
+#endif
+
+#endif // VM_H
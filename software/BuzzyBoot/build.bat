@@ -0,0 +1,7 @@
+set TOOLCHAIN=C:\Program Files (x86)\Atmel\Studio\7.0\toolchain\avr8\avr8-gnu-toolchain\bin
+set PACK=C:\Program Files (x86)\Atmel\Studio\7.0\packs\atmel\ATtiny_DFP\1.3.147
+for %%D in (attiny816 attiny1616) do (
+"%TOOLCHAIN%\avr-gcc.exe" -mmcu=%%D -B "%PACK%\gcc\dev\%%D" -I "%PACK%\include" -Os -funsigned-char -Wall -nostartfiles -o buzzyboot_%%D.elf buzzyboot.c
+"%TOOLCHAIN%\avr-objcopy.exe" -O ihex buzzyboot_%%D.elf buzzyboot_%%D.hex
+"%TOOLCHAIN%\avr-size.exe" buzzyboot_%%D.elf
+)
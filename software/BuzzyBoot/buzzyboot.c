@@ -0,0 +1,197 @@
+/* BuzzyBoot, I2C bootloader for BuzzyBee
+ *
+ * Lives in the first 512 bytes of flash, the boot section (BOOTEND fuse = 2),
+ * with the application linked from BOOT_SIZE. On reset it starts the
+ * application unless the application asked for the bootloader with a
+ * software reset, or the last update was not completed.
+ *
+ * It answers on the application's I2C address. Every command is one write
+ * transaction ended by a stop, and reading returns one BOOT_x status byte for
+ * the last command:
+ *
+ *   BOOT_CMD_PAGE addr_l addr_h data[PROGMEM_PAGE_SIZE] crc_l crc_h
+ *       Write the flash page at byte address addr if the data's CRC matches.
+ *       The first page of an update marks the application as incomplete.
+ *   BOOT_CMD_DONE len_l len_h crc_l crc_h
+ *       Check the CRC of len bytes of application from BOOT_SIZE, and mark
+ *       the application complete if it matches.
+ *   BOOT_CMD_RUN
+ *       Start the application, if complete.
+ *
+ * CRCs are CRC-16/CCITT as computed by _crc_ccitt_update(), from 0xFFFF.
+ *
+ * The application's length and CRC are kept in the first 4 bytes of USERROW.
+ * A length of 0 means an update was started and not verified, so a reset or
+ * power cut part way through an update comes back to the bootloader and never
+ * into a half written application. An erased USERROW is a device programmed
+ * over UPDI, which runs the application if there is one.
+ *
+ * build.bat builds it for each device, as the flash size is built in, and
+ * program.bat flashes the ATtiny1616 build along with the application.
+ *
+ * The application is built for the ATtiny1616, which has the ATtiny816's
+ * pinout and peripherals with 16 kB of flash, 15872 bytes of it after the
+ * boot section. On the ATtiny816 the boot section leaves 7680 bytes: the
+ * QTouch libraries alone take 5.4 kB, and the application before the I2C
+ * slave took 7654 bytes, so only the bootloader itself still fits there.
+ */
+#include <avr/io.h>
+#include <avr/xmega.h>
+#include <stdbool.h>
+#include <util/crc16.h>
+
+#include "../BuzzyBee/BuzzyBee/Config/buzzybee_config.h"
+
+#define BOOT_SIZE 512
+
+enum { BOOT_CMD_PAGE = 1, BOOT_CMD_DONE, BOOT_CMD_RUN };
+
+// Status, never the application's I2C_ID so a host can tell them apart
+#define BOOT_OK 0xA0
+#define BOOT_ERR_CMD 0xA1
+#define BOOT_ERR_LENGTH 0xA2
+#define BOOT_ERR_ADDR 0xA3
+#define BOOT_ERR_CRC 0xA4
+#define BOOT_ERR_INCOMPLETE 0xA5
+
+#define BOOT_RECORD ((volatile uint16_t *)USER_SIGNATURES_START)
+
+static void boot_nvm(uint8_t cmd)
+{
+	_PROTECTED_WRITE_SPM(NVMCTRL.CTRLA, cmd);
+	while (NVMCTRL.STATUS & (NVMCTRL_FBUSY_bm | NVMCTRL_EEBUSY_bm))
+		;
+}
+
+static void boot_record(uint16_t len, uint16_t crc)
+{
+	BOOT_RECORD[0] = len;
+	BOOT_RECORD[1] = crc;
+	boot_nvm(NVMCTRL_CMD_PAGEERASEWRITE_gc);
+}
+
+static bool boot_app_complete(void)
+{
+	return BOOT_RECORD[0] != 0 && *(volatile uint16_t *)(MAPPED_PROGMEM_START + BOOT_SIZE) != 0xFFFF;
+}
+
+static void boot_run_app(void)
+{
+	TWI0.SCTRLA = 0;
+	// Function pointers are word addresses
+	((void (*)(void))(BOOT_SIZE / 2))();
+}
+
+// No C runtime: main() is entered straight from reset and nothing may rely on
+// initialised or zeroed globals
+int main(void) __attribute__((OS_main, used, section(".init9")));
+int main(void)
+{
+	uint8_t  status = BOOT_OK;
+	uint8_t  cmd    = 0;
+	uint8_t  count  = 0;
+	uint16_t addr   = 0;
+	uint16_t arg    = 0;
+	uint16_t crc    = 0;
+
+	asm volatile("clr __zero_reg__");
+
+	if (!(RSTCTRL.RSTFR & RSTCTRL_SWRF_bm) && boot_app_complete()) {
+		boot_run_app();
+	}
+	RSTCTRL.RSTFR = RSTCTRL_SWRF_bm;
+
+	// The SAO header is on TWI0's alternate pins, PA1 and PA2
+	PORTMUX.CTRLB = PORTMUX_TWI0_bm;
+	TWI0.SADDR    = I2C_SLAVE_ADDRESS << 1;
+	TWI0.SCTRLA   = TWI_PIEN_bm | TWI_ENABLE_bm;
+
+	for (;;) {
+		uint8_t s = TWI0.SSTATUS;
+
+		if (s & TWI_APIF_bm) {
+			if (s & TWI_AP_bm) {
+				// Addressed, a new transaction
+				cmd   = 0;
+				count = 0;
+				crc   = 0xFFFF;
+				TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+				continue;
+			}
+
+			// Stop, run the command just written
+			TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+			if (cmd == BOOT_CMD_PAGE) {
+				if (count != 3 + PROGMEM_PAGE_SIZE + 2) {
+					status = BOOT_ERR_LENGTH;
+				} else if (addr < BOOT_SIZE || addr >= PROGMEM_SIZE || (addr & (PROGMEM_PAGE_SIZE - 1))) {
+					status = BOOT_ERR_ADDR;
+				} else if (crc != arg) {
+					status = BOOT_ERR_CRC;
+				} else {
+					boot_nvm(NVMCTRL_CMD_PAGEERASEWRITE_gc);
+					status = BOOT_OK;
+				}
+				if (status != BOOT_OK) {
+					boot_nvm(NVMCTRL_CMD_PAGEBUFCLR_gc);
+				}
+			} else if (cmd == BOOT_CMD_DONE) {
+				status = BOOT_ERR_LENGTH;
+				if (count == 5 && addr && addr <= PROGMEM_SIZE - BOOT_SIZE) {
+					const uint8_t *p = (const uint8_t *)(MAPPED_PROGMEM_START + BOOT_SIZE);
+					for (uint16_t i = addr; i; i--) {
+						crc = _crc_ccitt_update(crc, *p++);
+					}
+					status = BOOT_ERR_CRC;
+					if (crc == arg) {
+						boot_record(addr, arg);
+						status = BOOT_OK;
+					}
+				}
+			} else if (cmd == BOOT_CMD_RUN) {
+				status = BOOT_ERR_INCOMPLETE;
+				if (boot_app_complete()) {
+					boot_run_app();
+				}
+			} else if (count) {
+				status = BOOT_ERR_CMD;
+			}
+			cmd = 0;
+		} else if (s & TWI_DIF_bm) {
+			if (s & TWI_DIR_bm) {
+				// Master reads the status, until it NACKs
+				if (count++ && (s & TWI_RXACK_bm)) {
+					TWI0.SCTRLB = TWI_SCMD_COMPTRANS_gc;
+				} else {
+					TWI0.SDATA  = status;
+					TWI0.SCTRLB = TWI_SCMD_RESPONSE_gc;
+				}
+				continue;
+			}
+
+			uint8_t d = TWI0.SDATA;
+
+			if (count == 0) {
+				cmd = d;
+			} else if (count <= 2) {
+				addr = (addr >> 8) | ((uint16_t)d << 8);
+				if (count == 1 && cmd == BOOT_CMD_PAGE && BOOT_RECORD[0] != 0) {
+					// Before any page data is in the page buffer
+					boot_record(0, 0);
+				}
+			} else if (cmd == BOOT_CMD_PAGE && count < 3 + PROGMEM_PAGE_SIZE) {
+				// Straight into the page buffer, masked so a bad address cannot reach outside flash
+				*(volatile uint8_t *)(MAPPED_PROGMEM_START
+				                      + ((addr & (PROGMEM_SIZE - PROGMEM_PAGE_SIZE)) | (count - 3)))
+				    = d;
+				crc = _crc_ccitt_update(crc, d);
+			} else {
+				arg = (arg >> 8) | ((uint16_t)d << 8);
+			}
+			if (count != 0xFF) {
+				count++;
+			}
+			TWI0.SCTRLB = TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc;
+		}
+	}
+}
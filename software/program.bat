@@ -1 +1,3 @@
-"C:\Program Files (x86)\Atmel\Studio\7.0\atbackend\atprogram.exe" -v -i updi -d attiny816 -t medbg program -c -f "BuzzyBee\BuzzyBee\Release\BuzzyBee.hex"
\ No newline at end of file
+"C:\Program Files (x86)\Atmel\Studio\7.0\atbackend\atprogram.exe" -v -i updi -d attiny1616 -t medbg program -c -f "BuzzyBoot\buzzyboot_attiny1616.hex"
+"C:\Program Files (x86)\Atmel\Studio\7.0\atbackend\atprogram.exe" -v -i updi -d attiny1616 -t medbg program -f "BuzzyBee\BuzzyBee\Release\BuzzyBee.hex"
+"C:\Program Files (x86)\Atmel\Studio\7.0\atbackend\atprogram.exe" -v -i updi -d attiny1616 -t medbg write -fs -o 8 --values 02
\ No newline at end of file
@@ -1 +0,0 @@
-"C:\Program Files (x86)\Atmel\Studio\7.0\atbackend\atprogram.exe" -v -i updi -d attiny1616 -t medbg program -c -f "BuzzyBee\BuzzyBee\Release\BuzzyBee.hex"
\ No newline at end of file
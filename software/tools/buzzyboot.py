@@ -0,0 +1,338 @@
+#!/usr/bin/env python3
+"""Upload BuzzyBee firmware over I2C through the BuzzyBoot bootloader.
+
+The host must be wired to the SAO header's I2C bus. A running application is
+first reset into the bootloader through its I2C_REG_BOOT register. Then the
+image is written page by page, each page CRC-checked by the bootloader and
+retried on error, verified as a whole, and started. See
+BuzzyBoot/buzzyboot.c for the protocol.
+
+    buzzyboot.py BuzzyBee.hex                  upload on /dev/i2c-1
+    buzzyboot.py BuzzyBee.hex --bus 3 --address 0x43
+    buzzyboot.py BuzzyBee.hex --device attiny816
+    buzzyboot.py BuzzyBee.hex --emulate        upload to an emulated target,
+                                               with bus errors and a power cut
+    buzzyboot.py --self-test                   emulated uploads of the largest
+                                               image each device takes
+
+The image must be linked from BOOT_SIZE, as the Release build is. --device
+must match the part, and the bootloader build on it: it sets the flash and
+page size, ATtiny1616 by default.
+"""
+
+import argparse
+import fcntl
+import os
+import random
+import sys
+import tempfile
+import time
+from collections import namedtuple
+
+BOOT_SIZE = 512
+
+# Parts BuzzyBoot is built for, see build.bat
+Device = namedtuple("Device", "flash_size page_size")
+DEVICES = {
+    "attiny816": Device(8192, 64),
+    "attiny1616": Device(16384, 64),
+}
+
+CMD_PAGE = 1
+CMD_DONE = 2
+CMD_RUN = 3
+
+BOOT_OK = 0xA0
+BOOT_ERR_CMD = 0xA1
+BOOT_ERR_LENGTH = 0xA2
+BOOT_ERR_ADDR = 0xA3
+BOOT_ERR_CRC = 0xA4
+BOOT_ERR_INCOMPLETE = 0xA5
+
+# Application registers, from i2c_registers.h
+I2C_REG_BOOT = 0x0B
+I2C_REG_ID = 0x80
+I2C_BOOT_MAGIC = 0xB7
+I2C_ID = 0xBB
+
+RETRIES = 5
+
+
+def crc16(data, crc=0xFFFF):
+    """CRC-16/CCITT the way avr-libc's _crc_ccitt_update() computes it."""
+    for byte in data:
+        crc ^= byte
+        for _ in range(8):
+            crc = (crc >> 1) ^ 0x8408 if crc & 1 else crc >> 1
+    return crc
+
+
+def read_hex(path, device):
+    """Load an Intel HEX file into an application image starting at BOOT_SIZE."""
+    memory = {}
+    base = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(":"):
+                continue
+            record = bytes.fromhex(line[1:])
+            if sum(record) & 0xFF:
+                raise ValueError("bad checksum in " + line)
+            count, address, kind = record[0], record[1] << 8 | record[2], record[3]
+            data = record[4:4 + count]
+            if kind == 0:
+                for i, byte in enumerate(data):
+                    memory[base + address + i] = byte
+            elif kind == 2:
+                base = (data[0] << 8 | data[1]) << 4
+            elif kind == 4:
+                base = (data[0] << 8 | data[1]) << 16
+            elif kind == 1:
+                break
+    if not memory:
+        raise ValueError("empty image")
+    if min(memory) < BOOT_SIZE:
+        raise ValueError("image is not linked from 0x%04X" % BOOT_SIZE)
+    if max(memory) >= device.flash_size:
+        raise ValueError("image does not fit in flash")
+    end = (max(memory) + device.page_size) // device.page_size * device.page_size
+    return bytes(memory.get(a, 0xFF) for a in range(BOOT_SIZE, end))
+
+
+class LinuxI2C:
+    """Plain I2C transactions through Linux i2c-dev."""
+
+    I2C_SLAVE = 0x0703
+
+    def __init__(self, bus, address):
+        self.fd = os.open("/dev/i2c-%d" % bus, os.O_RDWR)
+        fcntl.ioctl(self.fd, self.I2C_SLAVE, address)
+
+    def write(self, data):
+        os.write(self.fd, bytes(data))
+
+    def read(self, count):
+        return os.read(self.fd, count)
+
+
+class EmulatedTarget:
+    """BuzzyBee with BuzzyBoot, emulated at the transaction level.
+
+    Follows the bootloader's state machine, including the USERROW record that
+    keeps an interrupted update in the bootloader, with the flash and page
+    size of the device it is built for. error_rate is the chance of a bit
+    error in each page written.
+    """
+
+    def __init__(self, device, error_rate=0.0):
+        self.device = device
+        self.flash = bytearray([0xFF] * device.flash_size)
+        self.record = [0xFFFF, 0xFFFF]
+        self.error_rate = error_rate
+        self.status = BOOT_OK
+        self.pointer = 0
+        self.software_reset = False
+        self.pages_written = 0
+        self.reset()
+
+    def complete(self):
+        first = self.flash[BOOT_SIZE] | self.flash[BOOT_SIZE + 1] << 8
+        return self.record[0] != 0 and first != 0xFFFF
+
+    def reset(self):
+        self.in_boot = self.software_reset or not self.complete()
+        self.software_reset = False
+
+    def write(self, data):
+        data = bytearray(data)
+        if not self.in_boot:
+            if data:
+                self.pointer = data[0]
+            if len(data) > 1 and data[0] == I2C_REG_BOOT and data[1] == I2C_BOOT_MAGIC:
+                self.software_reset = True
+                self.reset()
+            return
+        if not data:
+            return
+        command = data[0]
+        page_size, flash_size = self.device.page_size, self.device.flash_size
+        if command == CMD_PAGE and len(data) > 3 and random.random() < self.error_rate:
+            data[random.randrange(3, len(data))] ^= 1 << random.randrange(8)
+        address = data[1] | data[2] << 8 if len(data) >= 3 else 0
+        if command == CMD_PAGE:
+            if len(data) >= 2 and self.record[0] != 0:
+                self.record = [0, 0]
+            payload = data[3:3 + page_size]
+            received = data[-2] | data[-1] << 8
+            if len(data) != 3 + page_size + 2:
+                self.status = BOOT_ERR_LENGTH
+            elif address < BOOT_SIZE or address >= flash_size or address % page_size:
+                self.status = BOOT_ERR_ADDR
+            elif crc16(payload) != received:
+                self.status = BOOT_ERR_CRC
+            else:
+                self.flash[address:address + page_size] = payload
+                self.pages_written += 1
+                self.status = BOOT_OK
+        elif command == CMD_DONE:
+            self.status = BOOT_ERR_LENGTH
+            if len(data) == 5 and 0 < address <= flash_size - BOOT_SIZE:
+                received = data[3] | data[4] << 8
+                self.status = BOOT_ERR_CRC
+                if crc16(self.flash[BOOT_SIZE:BOOT_SIZE + address]) == received:
+                    self.record = [address, received]
+                    self.status = BOOT_OK
+        elif command == CMD_RUN:
+            self.status = BOOT_ERR_INCOMPLETE
+            if self.complete():
+                self.in_boot = False
+        else:
+            self.status = BOOT_ERR_CMD
+
+    def read(self, count):
+        if self.in_boot:
+            return bytes([self.status] * count)
+        return bytes([I2C_ID if self.pointer == I2C_REG_ID else 0xFF] * count)
+
+
+def command(bus, data):
+    bus.write(data)
+    return bus.read(1)[0]
+
+
+def enter_bootloader(bus):
+    bus.write([I2C_REG_ID])
+    if bus.read(1)[0] == I2C_ID:
+        bus.write([I2C_REG_BOOT, I2C_BOOT_MAGIC])
+        time.sleep(0.05)
+    # The bootloader takes any write as a command and reports a status
+    status = command(bus, [0])
+    if status & 0xF0 != BOOT_OK:
+        raise IOError("no bootloader, status 0x%02X" % status)
+
+
+def upload(bus, image, device, pages=None, log=print):
+    """Write the image, verify it and start it. Stops after `pages` pages if given."""
+    enter_bootloader(bus)
+    page_size = device.page_size
+    count = len(image) // page_size
+    for page in range(count if pages is None else pages):
+        address = BOOT_SIZE + page * page_size
+        data = image[page * page_size:(page + 1) * page_size]
+        crc = crc16(data)
+        packet = bytes([CMD_PAGE, address & 0xFF, address >> 8]) + data + bytes([crc & 0xFF, crc >> 8])
+        for attempt in range(RETRIES):
+            status = command(bus, packet)
+            if status == BOOT_OK:
+                break
+            log("page 0x%04X: status 0x%02X, retrying" % (address, status))
+        else:
+            raise IOError("page 0x%04X failed" % address)
+    if pages is not None:
+        return
+    crc = crc16(image)
+    for attempt in range(RETRIES):
+        status = command(bus, [CMD_DONE, len(image) & 0xFF, len(image) >> 8, crc & 0xFF, crc >> 8])
+        if status == BOOT_OK:
+            break
+    else:
+        raise IOError("verification failed, status 0x%02X" % status)
+    bus.write([CMD_RUN])
+    log("%d bytes written and verified" % len(image))
+
+
+def emulate(image, device):
+    """Exercise the uploader and the bootloader's recovery without hardware."""
+    random.seed(1)
+    pages = len(image) // device.page_size
+    target = EmulatedTarget(device, error_rate=0.05)
+    upload(target, image, device)
+    assert not target.in_boot, "application did not start"
+    assert target.flash[BOOT_SIZE:BOOT_SIZE + len(image)] == image, "flash differs from image"
+    print("upload with bit errors: ok, %d page writes for %d pages" % (target.pages_written, pages))
+
+    # Power cut half way through an update
+    upload(target, bytes(image[::-1]), device, pages=pages // 2, log=lambda s: None)
+    target.reset()
+    assert target.in_boot, "half written application was started"
+    upload(target, image, device, log=lambda s: None)
+    assert not target.in_boot and target.flash[BOOT_SIZE:BOOT_SIZE + len(image)] == image
+    print("power cut during update: ok, came back in the bootloader and recovered")
+
+
+def write_hex(path, image):
+    """Write an application image linked from BOOT_SIZE as Intel HEX."""
+    with open(path, "w") as f:
+        for offset in range(0, len(image), 16):
+            address = BOOT_SIZE + offset
+            data = image[offset:offset + 16]
+            record = bytes([len(data), address >> 8, address & 0xFF, 0]) + data
+            f.write(":%s%02X\n" % (record.hex().upper(), -sum(record) & 0xFF))
+        f.write(":00000001FF\n")
+
+
+def self_test():
+    """Emulated uploads of the largest image each device takes, through a HEX file."""
+    for name, device in sorted(DEVICES.items()):
+        rng = random.Random(name)
+        image = bytes(rng.randrange(256) for _ in range(device.flash_size - BOOT_SIZE))
+        with tempfile.TemporaryDirectory() as tmp:
+            path = os.path.join(tmp, "image.hex")
+            write_hex(path, image)
+            assert read_hex(path, device) == image, "HEX round trip differs"
+            print("%s, %d bytes:" % (name, len(image)))
+            emulate(image, device)
+
+            # One page too many
+            write_hex(path, image + bytes(device.page_size))
+            try:
+                read_hex(path, device)
+            except ValueError:
+                print("image past the end of flash: ok, refused")
+            else:
+                raise AssertionError("oversized image accepted")
+
+    # An ATtiny1616 image on an ATtiny816 bootloader
+    small, large = DEVICES["attiny816"], DEVICES["attiny1616"]
+    image = bytes(random.Random(0).randrange(256) for _ in range(9000))
+    target = EmulatedTarget(small)
+    try:
+        upload(target, image, large, log=lambda s: None)
+    except IOError:
+        print("9000 bytes on an emulated attiny816: ok, refused by the bootloader")
+    else:
+        raise AssertionError("attiny816 bootloader accepted an image past its flash")
+    print("all passed")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("hex", nargs="?", help="application image, Intel HEX")
+    parser.add_argument("--bus", type=int, default=1, help="Linux I2C bus number")
+    parser.add_argument("--address", type=lambda s: int(s, 0), default=0x42, help="BuzzyBee I2C address")
+    parser.add_argument("--device", choices=sorted(DEVICES), default="attiny1616",
+                        help="target part, sets the flash and page size")
+    parser.add_argument("--emulate", action="store_true", help="use an emulated target")
+    parser.add_argument("--self-test", action="store_true", help="run the emulated uploads and exit")
+    args = parser.parse_args()
+
+    if args.self_test:
+        self_test()
+        return 0
+    if args.hex is None:
+        parser.error("the image is required")
+
+    device = DEVICES[args.device]
+    image = read_hex(args.hex, device)
+    if args.emulate:
+        emulate(image, device)
+    else:
+        start = time.time()
+        upload(LinuxI2C(args.bus, args.address), image, device)
+        print("%.1f s" % (time.time() - start))
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,130 @@
+#!/usr/bin/env python3
+"""Decode and plot the BuzzyBee binary touch data stream.
+
+The firmware streams one frame per touch measurement on USART0 TXD (PB2,
+test pad J18) when DEF_TOUCH_DATA_STREAMER_ENABLE is set in qtouch/touch.h.
+See qtouch/datastreamer/datastreamer.h for the frame layout.
+
+    datastreamer_plot.py COM5              live plot (needs matplotlib)
+    datastreamer_plot.py COM5 --csv        print frames as CSV
+    datastreamer_plot.py capture.bin --csv decode a raw capture file
+
+Requires pyserial when reading from a serial port.
+"""
+
+import argparse
+import collections
+import os
+import struct
+import sys
+
+SYNC = 0xA5
+BAUD = 115200
+NODE_FORMAT = struct.Struct("<HHhHB")
+
+
+class Decoder:
+    """Splits a byte stream into frames, resynchronising on bad checksums."""
+
+    def __init__(self):
+        self.buffer = bytearray()
+        self.last_sequence = None
+        self.lost = 0
+        self.bad = 0
+
+    def feed(self, data):
+        self.buffer.extend(data)
+        frames = []
+        while True:
+            start = self.buffer.find(bytes([SYNC]))
+            if start < 0:
+                self.buffer.clear()
+                break
+            del self.buffer[:start]
+            if len(self.buffer) < 3:
+                break
+            count = self.buffer[2]
+            size = 4 + NODE_FORMAT.size * count
+            if len(self.buffer) < size:
+                break
+            body = self.buffer[1:size]
+            checksum = 0
+            for byte in body[:-1]:
+                checksum ^= byte
+            if count == 0 or checksum != body[-1]:
+                self.bad += 1
+                del self.buffer[:1]
+                continue
+            sequence = body[0]
+            if self.last_sequence is not None:
+                self.lost += (sequence - self.last_sequence - 1) & 0xFF
+            self.last_sequence = sequence
+            nodes = [NODE_FORMAT.unpack_from(body, 2 + i * NODE_FORMAT.size) for i in range(count)]
+            frames.append((sequence, nodes))
+            del self.buffer[:size]
+        return frames
+
+
+def open_source(name):
+    if os.path.isfile(name):
+        return open(name, "rb"), False
+    import serial
+
+    return serial.Serial(name, BAUD, timeout=0.05), True
+
+
+def run_csv(source, decoder):
+    print("sequence,node,signal,reference,delta,compcap,state")
+    while True:
+        data = source.read(256)
+        if not data and not getattr(source, "is_open", False):
+            break
+        for sequence, nodes in decoder.feed(data):
+            for index, (signal, reference, delta, compcap, state) in enumerate(nodes):
+                print("%d,%d,%d,%d,%d,0x%04X,0x%02X" % (sequence, index, signal, reference, delta, compcap, state))
+    print("# lost %d frames, %d bad checksums" % (decoder.lost, decoder.bad), file=sys.stderr)
+
+
+def run_plot(source, decoder, history):
+    import matplotlib.animation as animation
+    import matplotlib.pyplot as plt
+
+    series = collections.defaultdict(lambda: collections.deque(maxlen=history))
+    figure, (ax_signal, ax_delta) = plt.subplots(2, 1, sharex=True)
+
+    def update(_):
+        for _, nodes in decoder.feed(source.read(1024)):
+            for index, (signal, reference, delta, _, _) in enumerate(nodes):
+                series[("signal", index)].append(signal)
+                series[("reference", index)].append(reference)
+                series[("delta", index)].append(delta)
+        ax_signal.cla()
+        ax_delta.cla()
+        for (kind, index), values in sorted(series.items()):
+            axis = ax_delta if kind == "delta" else ax_signal
+            axis.plot(list(values), label="%s %d" % (kind, index))
+        ax_signal.legend(loc="upper left")
+        ax_delta.legend(loc="upper left")
+        ax_delta.set_xlabel("frame (lost %d, bad %d)" % (decoder.lost, decoder.bad))
+
+    _ = animation.FuncAnimation(figure, update, interval=50, cache_frame_data=False)
+    plt.show()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("source", help="serial port or raw capture file")
+    parser.add_argument("--csv", action="store_true", help="print frames as CSV instead of plotting")
+    parser.add_argument("--history", type=int, default=500, help="frames shown in the plot")
+    args = parser.parse_args()
+
+    source, _ = open_source(args.source)
+    decoder = Decoder()
+    if args.csv:
+        run_csv(source, decoder)
+    else:
+        run_plot(source, decoder, args.history)
+
+
+if __name__ == "__main__":
+    main()
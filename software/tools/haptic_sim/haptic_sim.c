@@ -0,0 +1,93 @@
+/* Motor model for the BuzzyBee haptics' kick and brake
+ *
+ * Builds the firmware's haptic.c for the host against the register mock of
+ * the I2C harness, steps haptic_tick() once per emulated millisecond and
+ * feeds the duty it leaves in TCA0.SINGLE.CMP1BUF to a first order model of
+ * the ERM motor: speed moves towards the duty with a time constant of
+ * MOTOR_TAU_MS when driven, and coasts down with the same time constant
+ * when off, as a low side switch cannot brake it.
+ *
+ * For each change of level it prints how long the speed takes to get
+ * within 5% of full scale of the new level, and how long the drive stays
+ * at full or off before settling. The Makefile builds it once with the
+ * HAPTIC_KICK_MS and HAPTIC_BRAKE_MS of buzzybee_config.h and once with
+ * both 0, see haptic_sim.log.
+ *
+ *     make run
+ */
+
+#include <stdio.h>
+
+#include <atmel_start.h>
+#include <buzzybee_config.h>
+
+#include "haptic.h"
+
+#ifndef MOTOR_TAU_MS
+#define MOTOR_TAU_MS 40.0
+#endif
+
+TCA_t     TCA0;
+PORTMUX_t PORTMUX;
+reg8_t    SREG;
+
+static double speed;
+
+static const struct {
+	uint8_t from, to;
+} steps[] = {
+	{0, 255}, {0, 180}, {0, 60}, {60, 200}, {180, 60}, {200, 100}, {255, 0}, {60, 0},
+};
+
+static uint8_t duty(void)
+{
+	uint16_t cmp = TCA0.SINGLE.CMP1BUF;
+
+	return cmp > 255 ? 255 : cmp;
+}
+
+// Run until settled, return the ms taken and the ms the drive was pinned
+static int settle(uint8_t level, int *pinned)
+{
+	int reached = -1;
+
+	*pinned = 0;
+	for (int ms = 0; ms < 400; ms++) {
+		haptic_tick();
+		uint8_t d = duty();
+
+		if ((d == 255 || d == 0) && d != level && ms == *pinned) {
+			(*pinned)++;
+		}
+		speed += (d - speed) / MOTOR_TAU_MS;
+		if (speed > level - 12.75 && speed < level + 12.75) {
+			if (reached < 0) {
+				reached = ms + 1;
+			}
+		} else {
+			reached = -1;
+		}
+	}
+	return reached;
+}
+
+int main(void)
+{
+	printf("HAPTIC_KICK_MS %d, HAPTIC_BRAKE_MS %d, motor tau %.0f ms\n", HAPTIC_KICK_MS, HAPTIC_BRAKE_MS,
+	       MOTOR_TAU_MS);
+	printf("  change     settled  kick/brake\n");
+
+	haptic_init();
+	for (unsigned i = 0; i < sizeof(steps) / sizeof(steps[0]); i++) {
+		int pinned;
+
+		// Start from the motor settled at the first level
+		haptic_set(steps[i].from);
+		settle(steps[i].from, &pinned);
+
+		haptic_set(steps[i].to);
+		int t = settle(steps[i].to, &pinned);
+		printf("  %3u -> %3u  %4d ms  %5d ms\n", steps[i].from, steps[i].to, t, pinned);
+	}
+	return 0;
+}
@@ -0,0 +1,540 @@
+/* Off-target harness for the BuzzyBee I2C slave
+ *
+ * Builds the firmware's i2c_registers.c, with the mailbox, framebuffer and
+ * touch event queue it reaches into, for the host against the register
+ * mock in mock/avr/io.h. The harness plays the TWI0 peripheral: for every
+ * bus event it sets SSTATUS and SDATA the way the hardware would, calls
+ * ISR(TWI0_TWIS_vect) and checks the command the ISR leaves in SCTRLB.
+ * Scripted transactions then check the register map, repeated starts,
+ * master NACKs, collisions and bus errors, and general call syncs.
+ *
+ * A stand-in for a streaming host then sends frames at a range of rates
+ * on an emulated clock and reports the frame rate the board shows.
+ *
+ * The ISR's AVR cycles per byte are counted from its assembly instead, see
+ * isr_cycles.py.
+ *
+ *     make run
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include <atmel_start.h>
+#include <buzzybee_config.h>
+
+#include "buzzybee.h"
+#include "framebuffer.h"
+#include "haptic.h"
+#include "i2c_registers.h"
+#include "mailbox.h"
+#include "render.h"
+#include "touch_events.h"
+#include "vm.h"
+
+// Peripherals the firmware touches
+PORT_t    PORTA, PORTB, PORTC;
+TCA_t     TCA0;
+TCB_t     TCB0;
+TWI_t     TWI0;
+NVMCTRL_t NVMCTRL;
+PORTMUX_t PORTMUX;
+CPUINT_t  CPUINT;
+RSTCTRL_t RSTCTRL;
+reg8_t    SREG;
+uint8_t   mock_eeprom[EEPROM_SIZE];
+
+// Firmware state from the modules left out of the build
+volatile uint8_t  LED_PWM[2];
+volatile uint8_t  LED_CEILING;
+volatile uint16_t timeTicks;
+volatile RUNMODE  run_mode;
+volatile uint8_t  touch_count[2];
+volatile bool     animation_synced;
+volatile uint16_t animation_sync_time;
+uint8_t           pwm_counter;
+uint8_t           render_periods;
+volatile bool     tick_synced;
+volatile uint16_t tick_sync_time;
+volatile bool     render_due;
+volatile bool     render_busy;
+volatile uint8_t  render_overruns;
+volatile uint16_t render_time;
+volatile uint16_t render_time_blend;
+volatile uint8_t  vm_state;
+volatile uint8_t  vm_pc;
+volatile uint8_t  vm_load_addr;
+volatile uint8_t  haptic_stream_level;
+volatile bool     haptic_streamed;
+
+qtm_touch_key_data_t qtlib_key_data_set1[DEF_NUM_SENSORS];
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+uint8_t sensor_health[DEF_NUM_SENSORS];
+uint8_t sensor_fault_count[DEF_NUM_SENSORS];
+#endif
+
+// Calls the mailbox makes, recorded
+static int saved;
+static uint8_t recalibrated;
+static int vm_ctrl = -1;
+static int pattern = -1;
+
+void settings_save(void)
+{
+	saved++;
+}
+
+void calibrate_node(uint16_t key)
+{
+	recalibrated |= 1 << key;
+}
+
+void vm_control(uint8_t ctrl)
+{
+	vm_ctrl = ctrl;
+}
+
+void haptic_play(uint8_t p)
+{
+	pattern = p;
+}
+
+void I2C_0_init(void)
+{
+}
+
+void I2C_0_open(void)
+{
+}
+
+// ISR(TWI0_TWIS_vect) is a plain function in the mock
+void TWI0_TWIS_vect(void);
+
+/* Bus model *****************************************************************/
+
+#define NO_CMD 0xFF
+
+static int failures;
+static const char *scenario;
+
+static uint8_t  prev_acked = 1;
+
+static void check(bool ok, const char *what)
+{
+	if (!ok) {
+		printf("  FAIL %s: %s\n", scenario, what);
+		failures++;
+	}
+}
+
+// Raise the interrupt with status and data, return the ISR's SCTRLB command
+static uint8_t twi_event(uint8_t status, uint8_t data)
+{
+	TWI0.SSTATUS = status;
+	TWI0.SDATA   = data;
+	TWI0.SCTRLB  = NO_CMD;
+
+	TWI0_TWIS_vect();
+	return TWI0.SCTRLB;
+}
+
+static void bus_start(uint8_t addr, bool read)
+{
+	uint8_t cmd = twi_event(TWI_APIF_bm | TWI_AP_bm | (read ? TWI_DIR_bm : 0) | (prev_acked ? 0 : TWI_RXACK_bm),
+	                        (addr << 1) | read);
+	check(cmd == (TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc), "address not acknowledged");
+}
+
+static void bus_stop(void)
+{
+	check(twi_event(TWI_APIF_bm, 0) == TWI_SCMD_COMPTRANS_gc, "stop not completed");
+}
+
+static void bus_write(uint8_t data)
+{
+	check(twi_event(TWI_DIF_bm, data) == (TWI_ACKACT_ACK_gc | TWI_SCMD_RESPONSE_gc),
+	      "written byte not acknowledged");
+}
+
+// The master reads a byte and acknowledges it, or with last NACKs it
+static uint8_t bus_read(bool first, bool last)
+{
+	uint8_t status = TWI_DIF_bm | TWI_DIR_bm;
+
+	// RXACK holds the master's answer to the previous byte
+	if (!first && !prev_acked) {
+		status |= TWI_RXACK_bm;
+	}
+	check(twi_event(status, 0xEE) == TWI_SCMD_RESPONSE_gc, "read byte not sent");
+	prev_acked = !last;
+	return TWI0.SDATA;
+}
+
+// After the NACKed last byte the slave sees DIF with RXACK and completes
+static void bus_read_end(void)
+{
+	check(twi_event(TWI_DIF_bm | TWI_DIR_bm | TWI_RXACK_bm, 0) == TWI_SCMD_COMPTRANS_gc,
+	      "NACK did not complete the transaction");
+}
+
+static void write_regs(uint8_t reg, const uint8_t *data, uint8_t n)
+{
+	bus_start(I2C_SLAVE_ADDRESS, false);
+	bus_write(reg);
+	for (uint8_t i = 0; i < n; i++) {
+		bus_write(data[i]);
+	}
+	bus_stop();
+}
+
+// Pointer write, repeated start, burst read
+static void read_regs(uint8_t reg, uint8_t *data, uint8_t n)
+{
+	bus_start(I2C_SLAVE_ADDRESS, false);
+	bus_write(reg);
+	bus_start(I2C_SLAVE_ADDRESS, true);
+	for (uint8_t i = 0; i < n; i++) {
+		data[i] = bus_read(i == 0, i == n - 1);
+	}
+	bus_read_end();
+	bus_stop();
+}
+
+static uint8_t read_reg(uint8_t reg)
+{
+	uint8_t data;
+
+	read_regs(reg, &data, 1);
+	return data;
+}
+
+/* Scenarios *****************************************************************/
+
+static void test_init(void)
+{
+	i2c_registers_init();
+	check(PORTMUX.CTRLB & PORTMUX_TWI0_bm, "TWI0 not on the SAO header pins");
+	check(CPUINT.LVL1VEC == TWI0_TWIS_vect_num, "slave not the level 1 interrupt");
+#if I2C_FAST_MODE_PLUS == 1
+	check(TWI0.CTRLA & TWI_FMPEN_bm, "Fast-mode Plus not enabled");
+#endif
+}
+
+static void test_write_burst(void)
+{
+	const uint8_t data[] = {MODE_BOUNCE, 10, 20, 200};
+
+	write_regs(I2C_REG_MODE, data, sizeof(data));
+	check(run_mode == MODE_BOUNCE, "mode not written");
+	check(LED_PWM[0] == 10 && LED_PWM[1] == 20, "LED levels not written");
+	check(LED_CEILING == 200, "ceiling not written");
+}
+
+static void test_ceiling(void)
+{
+	const uint8_t dark = 0;
+
+	write_regs(I2C_REG_CEILING, &dark, 1);
+	check(LED_CEILING == CEILING_MIN && read_reg(I2C_REG_CEILING) == CEILING_MIN, "ceiling below CEILING_MIN");
+}
+
+static void test_read_repeated_start(void)
+{
+	uint8_t data[2];
+
+	read_regs(I2C_REG_ID, data, sizeof(data));
+	check(data[0] == I2C_ID, "ID");
+	check(data[1] == I2C_VERSION, "version");
+
+	timeTicks = 0x1234;
+	read_regs(I2C_REG_TICKS_L, data, sizeof(data));
+	check(data[0] == 0x34 && data[1] == 0x12, "millisecond clock");
+}
+
+static void test_unmapped(void)
+{
+	uint8_t data[3];
+	uint8_t ceiling = LED_CEILING;
+	const uint8_t junk = 0x55;
+
+	read_regs(I2C_REG_RW_END, data, 1);
+	check(data[0] == 0xFF, "unmapped read-write register");
+	read_regs(I2C_REG_RO_END - 1, data, 3);
+	check(data[1] == 0xFF && data[2] == 0xFF, "read past the map");
+	write_regs(I2C_REG_RW_END, &junk, 1);
+	write_regs(I2C_REG_ID, &junk, 1);
+	check(read_reg(I2C_REG_ID) == I2C_ID, "read-only register written");
+	check(LED_CEILING == ceiling, "unmapped write landed");
+}
+
+static void test_health(void)
+{
+	uint8_t data[4];
+
+#if DEF_HEALTH_MONITOR_ENABLE == 1
+	sensor_health[1]      = SENSOR_HEALTH_STUCK;
+	sensor_fault_count[1] = 2;
+	read_regs(I2C_REG_KEY0_HEALTH, data, sizeof(data));
+	check(data[0] == 0 && data[1] == SENSOR_HEALTH_STUCK, "health flags");
+	check(data[2] == 0 && data[3] == 2, "fault counts");
+#else
+	read_regs(I2C_REG_KEY0_HEALTH, data, sizeof(data));
+	check(data[0] == SENSOR_HEALTH_DISABLED && data[1] == SENSOR_HEALTH_DISABLED, "monitor not reported off");
+	check(data[2] == 0 && data[3] == 0, "fault counts without the monitor");
+#endif
+}
+
+static void test_bad_mode(void)
+{
+	const uint8_t bad  = MODE_LAST + 1;
+	const uint8_t good = MODE_TWINKLE;
+
+	write_regs(I2C_REG_MODE, &good, 1);
+	write_regs(I2C_REG_MODE, &bad, 1);
+	check(run_mode == MODE_TWINKLE, "out of range mode stored");
+}
+
+static void test_bus_errors(void)
+{
+	uint8_t errors = read_reg(I2C_REG_ERRORS);
+	uint8_t level  = 7;
+
+	// Bus error halfway through a write, after the pointer
+	bus_start(I2C_SLAVE_ADDRESS, false);
+	bus_write(I2C_REG_LED0);
+	check(twi_event(TWI_BUSERR_bm, 0) == TWI_SCMD_COMPTRANS_gc, "bus error not completed");
+
+	// Collision while sending a read byte
+	bus_start(I2C_SLAVE_ADDRESS, true);
+	check(twi_event(TWI_DIF_bm | TWI_DIR_bm | TWI_COLL_bm, 0) == TWI_SCMD_COMPTRANS_gc,
+	      "collision not completed");
+	prev_acked = 1;
+
+	check(read_reg(I2C_REG_ERRORS) == (uint8_t)(errors + 2), "errors not counted");
+
+	// The next transaction starts over with a pointer
+	write_regs(I2C_REG_LED1, &level, 1);
+	check(LED_PWM[1] == 7, "write after a bus error");
+}
+
+static void test_events(void)
+{
+	uint8_t data[4];
+
+	touch_event_init();
+	touch_event_push(TOUCH_EVENT_PRESS | 0);
+	touch_event_push(0);
+	touch_event_push(TOUCH_EVENT_PRESS | 1);
+	check(read_reg(I2C_REG_EVENT_COUNT) == 3, "events queued");
+	check(PORTA.DIRSET & TOUCH_EVENT_ATTN_bm, "attention not pulled");
+
+	PORTA.DIRCLR = 0;
+	read_regs(I2C_REG_EVENT, data, sizeof(data));
+	check(data[0] == (TOUCH_EVENT_PRESS | 0) && data[1] == 0 && data[2] == (TOUCH_EVENT_PRESS | 1),
+	      "events out of order");
+	check(data[3] == TOUCH_EVENT_NONE, "empty queue");
+	check(read_reg(I2C_REG_EVENT_COUNT) == 0, "events left");
+	check(PORTA.DIRCLR & TOUCH_EVENT_ATTN_bm, "attention not released");
+}
+
+static void test_mailbox(void)
+{
+	const uint8_t cmd[]   = {3, 0, CMD_RECALIBRATE};
+	const uint8_t haptic[] = {HAPTIC_SWELL, 0, CMD_HAPTIC};
+	const uint8_t bad[]    = {0, 0, CMD_COUNT};
+	const uint8_t prog     = VM_CTRL_RUN;
+
+	write_regs(I2C_REG_CMD_ARG0, cmd, sizeof(cmd));
+	write_regs(I2C_REG_CMD_ARG0, haptic, sizeof(haptic));
+	write_regs(I2C_REG_PROG_CTRL, &prog, 1);
+	check(read_reg(I2C_REG_CMD_PENDING) == 3, "commands not queued");
+	mailbox_run();
+	check(recalibrated == 3, "recalibrate");
+	check(pattern == HAPTIC_SWELL, "haptic pattern");
+	check(vm_ctrl == VM_CTRL_RUN, "program control");
+	check(read_reg(I2C_REG_CMD_STATUS) == CMD_STATUS_OK, "status");
+
+	write_regs(I2C_REG_CMD_ARG0, bad, sizeof(bad));
+	mailbox_run();
+	check(read_reg(I2C_REG_CMD_STATUS) == CMD_STATUS_BAD_OPCODE, "bad opcode");
+
+	for (uint8_t i = 0; i <= MAILBOX_SIZE; i++) {
+		write_regs(I2C_REG_CMD, &cmd[2], 1);
+	}
+	check(read_reg(I2C_REG_CMD_STATUS) == CMD_STATUS_FULL, "full mailbox");
+	mailbox_run();
+	check(read_reg(I2C_REG_CMD_PENDING) == 0, "mailbox not emptied");
+}
+
+static void test_program_load(void)
+{
+	const uint8_t prog[] = {0, 0xA1, 0xA2, 0xA3};
+
+	vm_state = VM_RUNNING;
+	write_regs(I2C_REG_PROG_ADDR, prog, 1);
+	write_regs(I2C_REG_PROG_DATA, &prog[1], 3);
+	check(memcmp(mock_eeprom, &prog[1], 3) == 0, "program bytes");
+	check(vm_state == VM_STOPPED, "program not stopped");
+}
+
+static void test_stream(void)
+{
+	const uint8_t frame[] = {11, 22, 33, 0};
+	const uint8_t mode    = MODE_STREAM;
+	uint8_t dropped       = read_reg(I2C_REG_FB_DROPPED);
+
+	write_regs(I2C_REG_MODE, &mode, 1);
+	write_regs(I2C_REG_FB_LED0, frame, sizeof(frame));
+	check(fb_ready, "frame not committed");
+	write_regs(I2C_REG_FB_LED0, frame, sizeof(frame));
+	check(read_reg(I2C_REG_FB_DROPPED) == (uint8_t)(dropped + 1), "replaced frame not dropped");
+	framebuffer_present();
+	check(LED_PWM[0] == 11 && LED_PWM[1] == 22, "frame not shown");
+	check(haptic_streamed && haptic_stream_level == 33, "motor level not streamed");
+}
+
+static void test_general_call(void)
+{
+	const uint8_t other[] = {0x06};
+	uint8_t syncs = read_reg(I2C_REG_SYNC_COUNT);
+
+	TCB0.INTFLAGS = 0;
+	pwm_counter   = 9;
+	bus_start(0, false);
+	bus_write(I2C_GC_SYNC);
+	bus_write(0x34);
+	bus_write(0x12);
+	bus_stop();
+	check(animation_synced && animation_sync_time == 0x1234, "animation not synced");
+	check(tick_synced && tick_sync_time == 0x1235, "clock not handed to the tick ISR");
+	check(TCB0.INTFLAGS == TCB_CAPT_bm && pwm_counter == 0, "timers not restarted");
+	check(read_reg(I2C_REG_SYNC_COUNT) == (uint8_t)(syncs + 1), "sync not counted");
+
+	// Other general calls are acknowledged and ignored
+	animation_synced = false;
+	bus_start(0, false);
+	bus_write(other[0]);
+	bus_write(0x34);
+	bus_write(0x12);
+	bus_stop();
+	check(!animation_synced, "other general call synced");
+}
+
+static const struct {
+	const char *name;
+	void (*run)(void);
+} scenarios[] = {
+	{"init", test_init},
+	{"write burst", test_write_burst},
+	{"ceiling floor", test_ceiling},
+	{"read after repeated start", test_read_repeated_start},
+	{"unmapped registers", test_unmapped},
+	{"sensor health", test_health},
+	{"out of range mode", test_bad_mode},
+	{"collision and bus error", test_bus_errors},
+	{"touch events", test_events},
+	{"command mailbox", test_mailbox},
+	{"program load", test_program_load},
+	{"stream frames", test_stream},
+	{"general call sync", test_general_call},
+};
+
+/* Frame stream stand-in ****************************************************/
+
+// One software PWM period, 256 TCA0 overflows of 256 clocks, in ns
+#define PWM_PERIOD_NS (256ull * 256 * 1000000000 / F_CPU)
+// Start, address, pointer, three levels, commit and stop
+#define FRAME_BITS (1 + 9 + 5 * 9 + 1)
+
+/*============================================================================
+static void stream(uint32_t scl_hz, uint32_t rate, uint16_t *fps, uint32_t *dropped)
+------------------------------------------------------------------------------
+Purpose: Stream frames for three seconds of emulated time
+Input  : scl_hz: bus clock
+         rate: frames per second the host sends, 0 as fast as the bus goes
+Output : fps: fb_fps after the last second
+         dropped: frames fb_dropped counted over the run
+Notes  : Each frame is one burst from I2C_REG_FB_LED0 through the commit,
+         landing when its last bit has been clocked. The PWM ISR's
+         framebuffer_present() and the main loop's framebuffer_update() run
+         on the emulated clock, in place of the timers.
+============================================================================*/
+static void stream(uint32_t scl_hz, uint32_t rate, uint16_t *fps, uint32_t *dropped)
+{
+	const uint64_t bus_ns  = FRAME_BITS * 1000000000ull / scl_hz;
+	const uint64_t gap_ns  = rate ? 1000000000ull / rate : bus_ns;
+	const uint64_t end     = 3000000000ull;
+	const uint8_t  mode    = MODE_STREAM;
+	uint64_t next_frame    = (gap_ns > bus_ns ? gap_ns : bus_ns);
+	uint64_t next_pwm      = PWM_PERIOD_NS;
+	uint64_t next_ms       = 1000000;
+	uint8_t  last_dropped;
+	uint8_t  frame[]       = {0, 0, 0, 0};
+
+	write_regs(I2C_REG_MODE, &mode, 1);
+	framebuffer_present();
+	last_dropped = fb_dropped;
+	*dropped     = 0;
+
+	while (next_ms <= end) {
+		if (next_frame <= next_pwm && next_frame <= next_ms) {
+			frame[0]++;
+			write_regs(I2C_REG_FB_LED0, frame, sizeof(frame));
+			next_frame += gap_ns > bus_ns ? gap_ns : bus_ns;
+		} else if (next_pwm <= next_ms) {
+			framebuffer_present();
+			next_pwm += PWM_PERIOD_NS;
+		} else {
+			timeTicks++;
+			framebuffer_update();
+			*dropped += (uint8_t)(fb_dropped - last_dropped);
+			last_dropped = fb_dropped;
+			next_ms += 1000000;
+		}
+	}
+	*fps = fb_fps;
+}
+
+static void test_stream_rates(void)
+{
+	static const uint32_t scl[]   = {100000, 400000};
+	static const uint32_t rates[] = {30, 60, 120, 250, 305, 400, 1000, 0};
+
+	printf("\nStream stand-in, %u frames/s at most on the %llu us PWM period\n",
+	       (unsigned)(1000000000ull / PWM_PERIOD_NS), PWM_PERIOD_NS / 1000);
+	printf("  SCL      sent/s  fb_fps  dropped/s\n");
+	for (unsigned i = 0; i < sizeof(scl) / sizeof(scl[0]); i++) {
+		for (unsigned j = 0; j < sizeof(rates) / sizeof(rates[0]); j++) {
+			uint32_t sent = rates[j] ? rates[j] : scl[i] / FRAME_BITS;
+			uint32_t dropped;
+			uint16_t fps;
+
+			stream(scl[i], rates[j], &fps, &dropped);
+			printf("  %3uk  %10u  %6u  %9u\n", (unsigned)(scl[i] / 1000), (unsigned)sent, fps,
+			       (unsigned)(dropped / 3));
+			// One frame per PWM period at most, and none lost below that
+			check(fps <= 1000000000ull / PWM_PERIOD_NS + 1, "more frames than PWM periods");
+			if (sent < 300) {
+				check(fps + 1 >= sent && dropped == 0, "frames lost below the PWM rate");
+			}
+		}
+	}
+}
+
+int main(void)
+{
+	for (unsigned i = 0; i < sizeof(scenarios) / sizeof(scenarios[0]); i++) {
+		int before = failures;
+
+		scenario = scenarios[i].name;
+		scenarios[i].run();
+		printf("%-28s %s\n", scenario, failures == before ? "ok" : "FAILED");
+	}
+
+	scenario = "stream rates";
+	test_stream_rates();
+
+	printf("\n%s\n", failures ? "FAILED" : "all passed");
+	return failures ? EXIT_FAILURE : EXIT_SUCCESS;
+}
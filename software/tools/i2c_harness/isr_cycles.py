@@ -0,0 +1,205 @@
+#!/usr/bin/env python3
+"""Worst case AVR cycles of an interrupt handler, counted from its assembly.
+
+Reads the compiler's assembly output (avr-gcc -S) for the Release build and
+walks every path through the handler, counting cycles per instruction with
+the AVRxt timings of the tinyAVR 1-series, plus the interrupt response and
+the vector's JMP. Calls are followed into any function defined in the files
+given. Loops, indirect jumps and indirect calls cannot be bounded this way
+and fail the count, so the handler must have none.
+
+    isr_cycles.py --budget 180 __vector_24 i2c_registers.s
+
+Every byte on the bus is one interrupt, so the worst path is the per byte
+cost. Exits non-zero when it is over the budget.
+"""
+
+import argparse
+import re
+import sys
+
+# Interrupt response, with the PC pushed, then the vector table's JMP
+INTERRUPT_ENTRY = 3 + 3
+
+# AVRxt cycles, where not 1
+CYCLES = {
+    "adiw": 2, "sbiw": 2,
+    "ld": 2, "ldd": 2, "lds": 3, "lpm": 3, "elpm": 3,
+    "sts": 2, "pop": 2,
+    "rjmp": 2, "jmp": 3, "rcall": 2, "call": 3,
+    "ret": 4, "reti": 4,
+    "spm": 1, "sleep": 1, "wdr": 1, "break": 1,
+}
+
+TWO_WORDS = {"lds", "sts", "jmp", "call"}
+SKIPS = {"cpse", "sbrc", "sbrs", "sbic", "sbis"}
+INDIRECT = {"ijmp", "icall", "eijmp", "eicall"}
+
+# avr-gcc's ISR prologue and epilogue chunks, expanded by the assembler.
+# Counted as the full save and restore of r0, r1 and SREG.
+GCC_ISR_PROLOGUE = 1 + 1 + 1 + 1 + 1  # push r1, push r0, in, push r0, clr
+GCC_ISR_EPILOGUE = 2 + 1 + 2 + 2      # pop r0, out, pop r0, pop r1
+
+
+class CountError(Exception):
+    pass
+
+
+class Insn:
+    def __init__(self, mnemonic, operands, address, line):
+        self.mnemonic = mnemonic
+        self.operands = operands
+        self.address = address
+        self.line = line
+        self.size = 4 if mnemonic in TWO_WORDS else 2
+
+
+def parse(paths):
+    """Instructions of all files in order, and their labels' indexes."""
+    insns = []
+    labels = {}
+    for path in paths:
+        address = 0
+        with open(path) as f:
+            text = re.sub(r"/\*.*?\*/", "", f.read(), flags=re.S)
+        for number, line in enumerate(text.splitlines(), 1):
+            line = line.split(";")[0].strip()
+            while True:
+                match = re.match(r"([.\w$]+):\s*(.*)", line)
+                if not match:
+                    break
+                label = match.group(1)
+                # Local labels are per file, functions are global
+                labels[(path, label) if label.startswith(".") else label] = len(insns)
+                line = match.group(2)
+            if not line or line.startswith("."):
+                continue
+            parts = line.split(None, 1)
+            mnemonic = parts[0].lower()
+            operands = [o.strip() for o in parts[1].split(",")] if len(parts) > 1 else []
+            insn = Insn(mnemonic, operands, address, "%s:%d" % (path, number))
+            insn.path = path
+            insns.append(insn)
+            address += insn.size
+    return insns, labels
+
+
+class Counter:
+    def __init__(self, insns, labels):
+        self.insns = insns
+        self.labels = labels
+        self.calls = []
+
+    def target(self, index, operand):
+        insn = self.insns[index]
+        match = re.match(r"\.([+-]\d+)$", operand.replace(" ", ""))
+        if match:
+            address = insn.address + insn.size + int(match.group(1))
+            for i in range(index, len(self.insns)) if address > insn.address else range(index, -1, -1):
+                if self.insns[i].path == insn.path and self.insns[i].address == address:
+                    return i
+            raise CountError("%s: no instruction at %s" % (insn.line, operand))
+        for key in ((insn.path, operand), operand):
+            if key in self.labels:
+                return self.labels[key]
+        raise CountError("%s: %s is not in the files given" % (insn.line, operand))
+
+    def cost(self, insn):
+        if insn.mnemonic == "__gcc_isr":
+            return {"1": GCC_ISR_PROLOGUE, "2": GCC_ISR_EPILOGUE}.get(insn.operands[0], 0)
+        return CYCLES.get(insn.mnemonic, 1)
+
+    def function(self, entry):
+        """(worst, best, worst path) from entry to its ret or reti."""
+        if entry in self.calls:
+            raise CountError("%s: recursion" % self.insns[entry].line)
+        self.calls.append(entry)
+        try:
+            return self.walk(entry, set())
+        finally:
+            self.calls.pop()
+
+    def walk(self, index, seen):
+        """(worst, best, worst path) from index, seen holding the instructions on this path."""
+        cycles = 0
+        lines = []
+        while True:
+            if index >= len(self.insns):
+                raise CountError("ran off the end after %s" % self.insns[index - 1].line)
+            insn = self.insns[index]
+            if index in seen:
+                raise CountError("%s: loop" % insn.line)
+            seen.add(index)
+            m = insn.mnemonic
+            lines.append(insn.line)
+
+            if m in INDIRECT:
+                raise CountError("%s: %s cannot be bounded" % (insn.line, m))
+            if m in ("ret", "reti"):
+                cycles += self.cost(insn)
+                return cycles, cycles, lines
+            if m in ("rjmp", "jmp"):
+                cycles += self.cost(insn)
+                index = self.target(index, insn.operands[-1])
+                continue
+            if m in ("rcall", "call"):
+                worst, best, path = self.function(self.target(index, insn.operands[-1]))
+                callee = (cycles + self.cost(insn) + worst, cycles + self.cost(insn) + best)
+                cycles = 0
+                rest = self.walk(index + 1, seen)
+                return callee[0] + rest[0], callee[1] + rest[1], lines + path + rest[2]
+
+            if m.startswith("br"):
+                taken = self.target(index, insn.operands[-1])
+                arms = [(2, taken), (1, index + 1)]
+            elif m in SKIPS:
+                skipped = self.insns[index + 1]
+                arms = [(1 + skipped.size // 2, index + 2), (1, index + 1)]
+            else:
+                cycles += self.cost(insn)
+                index += 1
+                continue
+
+            results = []
+            for extra, arm in arms:
+                result = self.walk(arm, set(seen))
+                results.append((extra + result[0], extra + result[1], result[2]))
+            worst = max(results, key=lambda r: r[0])
+            best = min(r[1] for r in results)
+            return cycles + worst[0], cycles + best, lines + worst[2]
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("handler", help="interrupt handler's symbol, __vector_N")
+    parser.add_argument("asm", nargs="+", help="assembly files, the handler's and its callees'")
+    parser.add_argument("--budget", type=int, required=True, help="cycles the handler may take")
+    parser.add_argument("--path", action="store_true", help="list the worst path's instructions")
+    args = parser.parse_args()
+
+    try:
+        insns, labels = parse(args.asm)
+    except OSError as e:
+        print(e)
+        return 2
+    if args.handler not in labels:
+        print("%s is not defined in %s" % (args.handler, " ".join(args.asm)))
+        return 2
+    try:
+        worst, best, path = Counter(insns, labels).function(labels[args.handler])
+    except CountError as e:
+        print("cannot count %s: %s" % (args.handler, e))
+        return 2
+
+    worst += INTERRUPT_ENTRY
+    best += INTERRUPT_ENTRY
+    if args.path:
+        for line in path:
+            print("  " + line)
+    print("%s: %d to %d cycles with the interrupt entry, budget %d: %s" %
+          (args.handler, best, worst, args.budget, "ok" if worst <= args.budget else "OVER"))
+    return 0 if worst <= args.budget else 1
+
+
+if __name__ == "__main__":
+    sys.exit(main())
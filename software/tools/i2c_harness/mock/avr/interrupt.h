@@ -0,0 +1,5 @@
+#define ISR(v) void v(void)
+#define sei() do{}while(0)
+#define cli() do{}while(0)
+#define reti() do{}while(0)
+#define ISR_NAKED
@@ -0,0 +1,166 @@
+/* Host mock of the ATtiny1616 device header, see ../../i2c_harness.c
+ *
+ * Peripherals are plain structs in host memory, so firmware register
+ * accesses land where the harness can set and check them.
+ */
+#ifndef MOCK_AVR_IO_H
+#define MOCK_AVR_IO_H
+#include <stdint.h>
+typedef volatile uint8_t reg8_t;
+typedef volatile uint16_t reg16_t;
+typedef struct { reg8_t DIR, DIRSET, DIRCLR, DIRTGL, OUT, OUTSET, OUTCLR, OUTTGL, IN, INTFLAGS, PORTCTRL; reg8_t PIN0CTRL,PIN1CTRL,PIN2CTRL,PIN3CTRL,PIN4CTRL,PIN5CTRL,PIN6CTRL,PIN7CTRL; } PORT_t;
+typedef struct { reg8_t DIR, OUT, IN, INTFLAGS; } VPORT_t;
+extern PORT_t PORTA, PORTB, PORTC; extern VPORT_t VPORTA, VPORTB, VPORTC;
+typedef struct { reg8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLECLR, CTRLESET, CTRLFCLR, CTRLFSET, EVCTRL, INTCTRL, INTFLAGS, DBGCTRL, TEMP; reg16_t CNT, PER, CMP0, CMP1, CMP2, PERBUF, CMP0BUF, CMP1BUF, CMP2BUF; } TCA_SINGLE_t;
+typedef struct { reg8_t CTRLA, CTRLB, CTRLC, CTRLD, CTRLECLR, CTRLESET, EVCTRL, INTCTRL, INTFLAGS, DBGCTRL, TEMP; reg8_t LCNT, HCNT, LPER, HPER, LCMP0, HCMP0, LCMP1, HCMP1, LCMP2, HCMP2; } TCA_SPLIT_t;
+typedef union { TCA_SINGLE_t SINGLE; TCA_SPLIT_t SPLIT; } TCA_t; extern TCA_t TCA0;
+typedef struct { reg8_t CTRLA, CTRLB, EVCTRL, INTCTRL, INTFLAGS, STATUS, DBGCTRL, TEMP; reg16_t CNT, CCMP; } TCB_t; extern TCB_t TCB0;
+typedef struct { reg8_t CTRLA, STATUS, INTCTRL, INTFLAGS, TEMP, DBGCTRL, CLKSEL, PITCTRLA, PITSTATUS, PITINTCTRL, PITINTFLAGS, PITDBGCTRL; reg16_t CNT, PER, CMP; } RTC_t; extern RTC_t RTC;
+typedef struct { reg8_t CTRLA, DBGCTRL, MCTRLA, MCTRLB, MSTATUS, MBAUD, MADDR, MDATA, SCTRLA, SCTRLB, SSTATUS, SADDR, SDATA, SADDRMASK; } TWI_t; extern TWI_t TWI0;
+typedef struct { reg8_t RXDATAL, RXDATAH, TXDATAL, TXDATAH, STATUS, CTRLA, CTRLB, CTRLC, DBGCTRL, EVCTRL, TXPLCTRL, RXPLCTRL; reg16_t BAUD; } USART_t; extern USART_t USART0;
+typedef struct { reg8_t CTRLA, CTRLB, STATUS, INTCTRL, INTFLAGS, DATA; reg16_t ADDR; } NVMCTRL_t; extern NVMCTRL_t NVMCTRL;
+typedef struct { reg8_t DEVICEID0, DEVICEID1, DEVICEID2, SERNUM0, SERNUM1, SERNUM2, SERNUM3, SERNUM4, SERNUM5, SERNUM6, SERNUM7, SERNUM8, SERNUM9, TEMPSENSE0, TEMPSENSE1, OSC16ERR3V, OSC16ERR5V, OSC20ERR3V, OSC20ERR5V; } SIGROW_t; extern SIGROW_t SIGROW;
+typedef struct { reg8_t CTRLA, CTRLB, CTRLC, CTRLD; } PORTMUX_t; extern PORTMUX_t PORTMUX;
+typedef struct { reg8_t CTRLA; } SLPCTRL_t; extern SLPCTRL_t SLPCTRL;
+typedef struct { reg8_t CTRLA, CTRLB, VLMCTRLA, INTCTRL, INTFLAGS, STATUS; } BOD_t; extern BOD_t BOD;
+typedef struct { reg8_t CTRLA, STATUS, LVL0PRI, LVL1VEC; } CPUINT_t; extern CPUINT_t CPUINT;
+typedef struct { reg8_t RSTFR, SWRR; } RSTCTRL_t; extern RSTCTRL_t RSTCTRL;
+typedef struct { reg8_t MCLKCTRLA, MCLKCTRLB, MCLKLOCK, MCLKSTATUS, OSC20MCTRLA, OSC20MCALIBA, OSC20MCALIBB, OSC32KCTRLA, XOSC32KCTRLA; } CLKCTRL_t; extern CLKCTRL_t CLKCTRL;
+typedef struct { reg8_t CTRLA; } WDT_t; extern WDT_t WDT;
+typedef struct { reg8_t CCP, SPL, SPH, SREG; } CPU_t; extern CPU_t CPU;
+typedef struct { reg8_t WDTCFG, BODCFG, OSCCFG, TCD0CFG, SYSCFG0, SYSCFG1, APPEND, BOOTEND; } FUSE_t; extern FUSE_t FUSE;
+typedef struct { reg8_t GPIOR0, GPIOR1, GPIOR2, GPIOR3; } GPIO_t;
+extern reg8_t GPIOR0, GPIOR1, GPIOR2, GPIOR3, SREG;
+#define CCP_IOREG_gc 0xD8
+#define CCP_SPM_gc 0x9D
+#define PORT_PULLUPEN_bm 0x08
+#define PORT_PULLUPEN_bp 3
+#define PORT_INVEN_bm 0x80
+#define PORT_ISC_gm 0x07
+typedef enum { PORT_ISC_INTDISABLE_gc, PORT_ISC_BOTHEDGES_gc, PORT_ISC_RISING_gc, PORT_ISC_FALLING_gc, PORT_ISC_INPUT_DISABLE_gc, PORT_ISC_LEVEL_gc } PORT_ISC_t;
+#define RTC_CMP_bm 2
+#define RTC_CMP_bp 1
+#define RTC_OVF_bp 0
+#define RTC_PERBUSY_bm 4
+#define RTC_PRESCALER_DIV1_gc 0
+#define RTC_RTCEN_bp 0
+#define RTC_RUNSTDBY_bp 7
+#define TCA_SINGLE_OVF_bm 1
+#define TCA_SINGLE_OVF_bp 0
+#define TCA_SINGLE_CMP0_bm 0x10
+#define TCA_SINGLE_CMP0_bp 4
+#define TCA_SINGLE_CMP1_bm 0x20
+#define TCA_SINGLE_CMP1_bp 5
+#define TCA_SINGLE_CMP2_bp 6
+#define TCA_SINGLE_ALUPD_bp 3
+#define TCA_SINGLE_CMP0EN_bp 4
+#define TCA_SINGLE_CMP1EN_bp 5
+#define TCA_SINGLE_CMP2EN_bp 6
+#define TCA_SINGLE_CMP1EN_bm 0x20
+#define TCA_SINGLE_WGMODE_gm 7
+#define TCA_SINGLE_WGMODE_NORMAL_gc 0
+#define TCA_SINGLE_WGMODE_SINGLESLOPE_gc 3
+#define TCA_SINGLE_CLKSEL_DIV1_gc 0
+#define TCA_SINGLE_ENABLE_bp 0
+#define TCB_CAPT_bm 1
+#define TCB_CAPT_bp 0
+#define TCB_CLKSEL_CLKDIV2_gc 2
+#define TCB_ENABLE_bp 0
+#define TCB_RUNSTDBY_bp 6
+#define TCB_SYNCUPD_bp 4
+#define PORTMUX_TCA00_bm 1
+#define PORTMUX_TCA01_bm 2
+#define PORTMUX_USART0_bm 1
+#define PORTMUX_TWI0_bm 0x10
+#define TWI_ENABLE_bm 1
+#define TWI_SMEN_bm 2
+#define TWI_PIEN_bm 0x20
+#define TWI_APIEN_bm 0x40
+#define TWI_DIEN_bm 0x80
+#define TWI_PMEN_bm 0x04
+#define TWI_FMPEN_bm 0x02
+#define TWI0_TWIS_vect_num 24
+#define TWI_SDASETUP_4CYC_gc 0
+#define TWI_FMPEN_bp 1
+#define TWI_SDAHOLD_gm 0x0C
+#define TWI_SDAHOLD_50NS_gc 0x04
+#define TWI_SDASETUP_bm 0x10
+#define TWI_DIF_bm 0x80
+#define TWI_APIF_bm 0x40
+#define TWI_CLKHOLD_bm 0x20
+#define TWI_RXACK_bm 0x10
+#define TWI_COLL_bm 0x08
+#define TWI_BUSERR_bm 0x04
+#define TWI_DIR_bm 0x02
+#define TWI_AP_bm 0x01
+#define TWI_ACKACT_bm 0x04
+#define TWI_ACKACT_NACK_gc 0x04
+#define TWI_ACKACT_ACK_gc 0x00
+#define TWI_SCMD_gm 0x03
+#define TWI_SCMD_NOACT_gc 0
+#define TWI_SCMD_COMPTRANS_gc 2
+#define TWI_SCMD_RESPONSE_gc 3
+#define TWI_MCMD_gm 0x03
+#define TWI_MCMD_NOACT_gc 0
+#define TWI_MCMD_REPSTART_gc 1
+#define TWI_MCMD_RECVTRANS_gc 2
+#define TWI_MCMD_STOP_gc 3
+#define TWI_RIF_bm 0x80
+#define TWI_WIF_bm 0x40
+#define TWI_ARBLOST_bm 0x08
+#define TWI_BUSSTATE_gm 0x03
+#define TWI_BUSSTATE_UNKNOWN_gc 0
+#define TWI_BUSSTATE_IDLE_gc 1
+#define TWI_BUSSTATE_OWNER_gc 2
+#define TWI_BUSSTATE_BUSY_gc 3
+#define TWI_FLUSH_bm 0x08
+#define TWI_RIEN_bm 0x80
+#define TWI_WIEN_bm 0x40
+#define TWI_QCEN_bm 0x10
+#define TWI_TIMEOUT_gm 0x0C
+#define TWI_TIMEOUT_200US_gc 0x0C
+#define USART_TXEN_bm 0x40
+#define USART_DREIF_bm 0x20
+#define USART_DREIE_bm 0x20
+#define USART_TXCIF_bm 0x40
+#define USART_CHSIZE_8BIT_gc 0x03
+#define USART_CMODE_ASYNCHRONOUS_gc 0
+#define USART_PMODE_DISABLED_gc 0
+#define USART_SBMODE_1BIT_gc 0
+#define NVMCTRL_CMD_PAGEERASEWRITE_gc 3
+#define NVMCTRL_CMD_PAGEBUFCLR_gc 4
+#define NVMCTRL_CMD_PAGEERASE_gc 2
+#define NVMCTRL_CMD_PAGEWRITE_gc 1
+#define NVMCTRL_FBUSY_bm 1
+#define NVMCTRL_EEBUSY_bm 2
+#define NVMCTRL_BOOTLOCK_bm 2
+#define RSTCTRL_SWRE_bm 1
+#define RSTCTRL_PORF_bm 1
+#define RSTCTRL_BORF_bm 2
+#define RSTCTRL_EXTRF_bm 4
+#define RSTCTRL_WDRF_bm 8
+#define RSTCTRL_SWRF_bm 16
+#define RSTCTRL_UPDIRF_bm 32
+#define CPUINT_IVSEL_bm 0x40
+#define CPUINT_LVL0PRI_gp 0
+#define CLKCTRL_PDIV_2X_gc 0
+#define CLKCTRL_PEN_bp 0
+#define BOD_SLEEP_DIS_gc 0
+#define BOD_VLMCFG_ABOVE_gc 0
+#define BOD_VLMIE_bp 0
+#define BOD_VLMLVL_5ABOVE_gc 0
+#define MAPPED_PROGMEM_START 0x8000
+#define PROGMEM_START 0x0000
+#define PROGMEM_PAGE_SIZE 64
+#define PROGMEM_SIZE 0x4000
+#define USER_SIGNATURES_START 0x1300
+// The VM loads programs through the mapped EEPROM
+extern uint8_t mock_eeprom[];
+#define EEPROM_START ((uintptr_t)mock_eeprom)
+#define EEPROM_SIZE 256
+#define EEPROM_PAGE_SIZE 32
+#define SPM_PAGESIZE 64
+#define SIGNATURE_0 0x1E
+#define _SFR_MEM8(a) (*(volatile uint8_t*)(a))
+#define PIN3_bm 0x08
+#endif
@@ -0,0 +1,7 @@
+#include <stdint.h>
+#define PROGMEM
+#define pgm_read_byte(a) (*(const uint8_t*)(a))
+#define pgm_read_word(a) (*(const uint16_t*)(a))
+#define pgm_read_ptr(a) (*(void* const*)(a))
+#include <string.h>
+#define memcpy_P memcpy
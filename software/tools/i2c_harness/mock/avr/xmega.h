@@ -0,0 +1,3 @@
+#include <stdint.h>
+#define _PROTECTED_WRITE_SPM(reg, value) ((reg) = (value))
+#define _PROTECTED_WRITE(reg, value) ((reg) = (value))